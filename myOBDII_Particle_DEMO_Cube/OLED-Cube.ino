@@ -122,8 +122,22 @@ void drawCube()
 	oled.display();
 }
 
+// Print frames/sec once a second
+void reportFrameRate()
+{
+  static unsigned long lastTime = 0;
+  static unsigned long lastFrames = 0;
+  unsigned long now = millis();
+  if (now - lastTime < 1000) return;
+  unsigned long frames = oled.getFrameCount();
+  Serial.printf("%lu frames/sec\n", (frames - lastFrames) * 1000UL / (now - lastTime));
+  lastTime = now;
+  lastFrames = frames;
+}
+
 void setup()
 {
+  Serial.begin(9600);
   // These three lines of code are all you need to initialize the
   // OLED and print the splash screen.
 
@@ -140,5 +154,6 @@ void setup()
 void loop()
 {
 	drawCube();
+	reportFrameRate();
 	delay(ROTATION_SPEED);
 }
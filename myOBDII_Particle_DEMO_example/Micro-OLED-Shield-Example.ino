@@ -314,10 +314,29 @@ void printTitle(String title, int font)
   oled.clear(PAGE);
 }
 
+// Print frames/sec of display() since the last call
+void reportFrameRate(const char *name)
+{
+  static unsigned long lastTime = 0;
+  static unsigned long lastFrames = 0;
+  unsigned long now = millis();
+  unsigned long frames = oled.getFrameCount();
+  if (now > lastTime)
+    Serial.printf("%s: %lu frames, %lu frames/sec\n", name, frames - lastFrames,
+      (frames - lastFrames) * 1000UL / (now - lastTime));
+  lastTime = now;
+  lastFrames = frames;
+}
+
 void loop()
 {
+  reportFrameRate("start");
   pixelExample();  // Run the pixel example function
+  reportFrameRate("pixels");
   lineExample();   // Then the line example function
+  reportFrameRate("lines");
   shapeExample();  // Then the shape example
+  reportFrameRate("shapes");
   textExamples();  // Finally the text example
+  reportFrameRate("text");
 }
@@ -25,14 +25,26 @@ char serInStr[recvLEN];		// TODO - need to fix a value so that this will not tak
 uint8_t serCmd[recvLEN];
 
 // Add the font name as declared in the header file.  Remove as many as possible to get conserve FLASH memory.
+// Multi page fonts keep only their header here; their glyphs come from the atlas.
 const unsigned char *MicroOLED::fontsPointer[]={
 	font5x7
-	,font8x16
-	,sevensegment
-	,fontlargenumber
-	,space01
-	,space02
-	,space03
+	,FONT_HEADER(font8x16)
+	,FONT_HEADER(sevensegment)
+	,FONT_HEADER(fontlargenumber)
+	,FONT_HEADER(space01)
+	,FONT_HEADER(space02)
+	,FONT_HEADER(space03)
+};
+
+// Glyph data in page order, matching fontsPointer.  Single page fonts are already stored that way.
+const unsigned char *MicroOLED::glyphsPointer[]={
+	font5x7+FONTHEADERSIZE
+	,FONT_ATLAS(font8x16)
+	,FONT_ATLAS(sevensegment)
+	,FONT_ATLAS(fontlargenumber)
+	,FONT_ATLAS(space01)
+	,FONT_ATLAS(space02)
+	,FONT_ATLAS(space03)
 };
 
 #define I2C_FREQ 400000L
@@ -112,6 +124,9 @@ void MicroOLED::setup(micro_oled_mode mode, uint8_t rst, uint8_t dc, uint8_t cs)
 	dcPin = dc;
 	csPin = cs;
 	interface = mode;
+	frameSink = NULL;
+	frameSinkContext = NULL;
+	frameCount = 0;
 }
 
 /** \brief Initialisation of MicroOLED Library.
@@ -125,6 +140,7 @@ void MicroOLED::begin() {
 	setDrawMode(NORM);
 	setCursor(0,0);
 
+#ifndef MICROOLED_HOST
 	pinMode(rstPin, OUTPUT);
 
 	if (interface == MODE_SPI)
@@ -153,6 +169,7 @@ void MicroOLED::begin() {
 	// bring out of reset
 	pinMode(rstPin,INPUT_PULLUP);
 	//digitalWrite(rstPin, HIGH);
+#endif
 
 	// Init sequence for 64x48 OLED module
 	command(DISPLAYOFF);			// 0xAE
@@ -198,7 +215,7 @@ void MicroOLED::begin() {
     Setup DC and SS pins, then send command via SPI to SSD1306 controller.
 */
 void MicroOLED::command(uint8_t c) {
-
+#ifndef MICROOLED_HOST
 	if (interface == MODE_SPI)
 	{
 		digitalWrite(dcPin, LOW);
@@ -210,6 +227,9 @@ void MicroOLED::command(uint8_t c) {
 	{
 		i2cWrite(dcPin, I2C_COMMAND, c);
 	}
+#else
+	(void)c;
+#endif
 }
 
 /** \brief SPI data.
@@ -217,7 +237,7 @@ void MicroOLED::command(uint8_t c) {
     Setup DC and SS pins, then send data via SPI to SSD1306 controller.
 */
 void MicroOLED::data(uint8_t c) {
-
+#ifndef MICROOLED_HOST
 	if (interface == MODE_SPI)
 	{
 		digitalWrite(dcPin, HIGH);
@@ -229,6 +249,9 @@ void MicroOLED::data(uint8_t c) {
 	{
 		i2cWrite(dcPin, I2C_DATA, c);
 	}
+#else
+	(void)c;
+#endif
 }
 
 /** \brief Set SSD1306 page address.
@@ -329,6 +352,33 @@ void MicroOLED::display(void) {
 			data(screenmemory[i*0x40+j]);
 		}
 	}
+	frameCount++;
+	if (frameSink)
+	frameSink(screenmemory, frameSinkContext);
+}
+
+/** \brief Transfer part of display memory.
+
+    Move only the pages and columns of the screen buffer covering x,y to x+width,y+height, e.g. after an incremental widget update.
+*/
+void MicroOLED::display(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+	uint8_t i, j;
+
+	if ((width==0) || (height==0) || (x>=LCDWIDTH) || (y>=LCDHEIGHT))
+	return;
+	if (x+width>LCDWIDTH) width=LCDWIDTH-x;
+	if (y+height>LCDHEIGHT) height=LCDHEIGHT-y;
+
+	for (i=y/8; i<=(y+height-1)/8; i++) {
+		setPageAddress(i);
+		setColumnAddress(x);
+		for (j=x;j<x+width;j++) {
+			data(screenmemory[i*0x40+j]);
+		}
+	}
+	frameCount++;
+	if (frameSink)
+	frameSink(screenmemory, frameSinkContext);
 }
 
 /** \brief Override Arduino's Print.
@@ -375,7 +425,7 @@ void MicroOLED::pixel(uint8_t x, uint8_t y) {
     Draw color pixel in the screen buffer's x,y position with NORM or XOR draw mode.
 */
 void MicroOLED::pixel(uint8_t x, uint8_t y, uint8_t color, uint8_t mode) {
-	if ((x<0) ||  (x>=LCDWIDTH) || (y<0) || (y>=LCDHEIGHT))
+	if ((x>=LCDWIDTH) || (y>=LCDHEIGHT))
 	return;
 
 	if (mode==XOR) {
@@ -686,7 +736,7 @@ uint8_t MicroOLED::getFontType(void) {
     Set the current font type number, ie changing to different fonts base on the type provided.
 */
 uint8_t MicroOLED::setFontType(uint8_t type) {
-	if ((type>=TOTALFONTS) || (type<0))
+	if (type>=TOTALFONTS)
 	return false;
 
 	fontType=type;
@@ -695,6 +745,7 @@ uint8_t MicroOLED::setFontType(uint8_t type) {
 	fontStartChar=pgm_read_byte(fontsPointer[fontType]+2);
 	fontTotalChar=pgm_read_byte(fontsPointer[fontType]+3);
 	fontMapWidth=(pgm_read_byte(fontsPointer[fontType]+4)*100)+pgm_read_byte(fontsPointer[fontType]+5); // two bytes values into integer 16
+	fontGlyphs=glyphsPointer[fontType];
 	return true;
 }
 
@@ -729,9 +780,9 @@ void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c) {
 void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_t mode) {
 	// TODO - New routine to take font of any height, at the moment limited to font height in multiple of 8 pixels
 
-	uint8_t rowsToDraw,row, tempC;
+	uint8_t rowsToDraw,row, tempC, margin;
 	uint8_t i,j,temp;
-	uint16_t charPerBitmapRow,charColPositionOnBitmap,charRowPositionOnBitmap,charBitmapStartPosition;
+	const unsigned char *glyph;
 
 	if ((c<fontStartChar) || (c>(fontStartChar+fontTotalChar-1)))		// no bitmap for the required c
 	return;
@@ -742,39 +793,30 @@ void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_
 	rowsToDraw=fontHeight/8;	// 8 is LCD's page size, see SSD1306 datasheet
 	if (rowsToDraw<=1) rowsToDraw=1;
 
-	// the following draw function can draw anywhere on the screen, but SLOW pixel by pixel draw
-	if (rowsToDraw==1) {
-		for  (i=0;i<fontWidth+1;i++) {
-			if (i==fontWidth) // this is done in a weird way because for 5x7 font, there is no margin, this code add a margin after col 5
-			temp=0;
-			else
-			temp=pgm_read_byte(fontsPointer[fontType]+FONTHEADERSIZE+(tempC*fontWidth)+i);
-
-			for (j=0;j<8;j++) {			// 8 is the LCD's page height (see datasheet for explanation)
-				if (temp & 0x1) {
-					pixel(x+i, y+j, color,mode);
-				}
-				else {
-					pixel(x+i, y+j, !color,mode);
-				}
-
-				temp >>=1;
+	// for 5x7 font, there is no margin, so add a blank column after col 5
+	margin = (rowsToDraw==1) ? 1 : 0;
+
+	// glyphs are stored page by page, fontWidth bytes per page, see glyphsPointer
+	glyph=fontGlyphs+(uint16_t)tempC*fontWidth*rowsToDraw;
+
+	// on a page boundary whole bytes can be copied a page at a time
+	if ((y%8==0) && (x+fontWidth+margin<=LCDWIDTH) && (y+rowsToDraw*8<=LCDHEIGHT)) {
+		for (row=0;row<rowsToDraw;row++) {
+			uint8_t *dest=screenmemory+x+((y/8)+row)*LCDWIDTH;
+			for (i=0;i<fontWidth+margin;i++) {
+				temp = (i==fontWidth) ? 0 : pgm_read_byte(glyph+row*fontWidth+i);
+				if (color!=WHITE) temp=~temp;
+				if (mode==XOR) dest[i]^=temp;
+				else dest[i]=temp;
 			}
 		}
 		return;
 	}
 
-	// font height over 8 bit
-	// take character "0" ASCII 48 as example
-	charPerBitmapRow=fontMapWidth/fontWidth;  // 256/8 =32 char per row
-	charColPositionOnBitmap=tempC % charPerBitmapRow;  // =16
-	charRowPositionOnBitmap=int(tempC/charPerBitmapRow); // =1
-	charBitmapStartPosition=(charRowPositionOnBitmap * fontMapWidth * (fontHeight/8)) + (charColPositionOnBitmap * fontWidth) ;
-
-	// each row on LCD is 8 bit height (see datasheet for explanation)
-	for(row=0;row<rowsToDraw;row++) {
-		for (i=0; i<fontWidth;i++) {
-			temp=pgm_read_byte(fontsPointer[fontType]+FONTHEADERSIZE+(charBitmapStartPosition+i+(row*fontMapWidth)));
+	// otherwise draw anywhere on the screen, but SLOW pixel by pixel draw
+	for (row=0;row<rowsToDraw;row++) {
+		for (i=0;i<fontWidth+margin;i++) {
+			temp = (i==fontWidth) ? 0 : pgm_read_byte(glyph+row*fontWidth+i);
 			for (j=0;j<8;j++) {			// 8 is the LCD's page height (see datasheet for explanation)
 				if (temp & 0x1) {
 					pixel(x+i,y+j+(row*8), color, mode);
@@ -786,7 +828,6 @@ void  MicroOLED::drawChar(uint8_t x, uint8_t y, uint8_t c, uint8_t color, uint8_
 			}
 		}
 	}
-
 }
 
 /*
@@ -799,6 +840,72 @@ void MicroOLED::drawBitmap(const uint8_t * bitArray)
     screenmemory[i] = bitArray[i];
 }
 
+/** \brief Get screen buffer.
+
+    Return the 384 byte page buffer, laid out as 6 pages of 64 column bytes with bit 0 at the top.
+*/
+uint8_t *MicroOLED::getScreenBuffer(void) {
+	return screenmemory;
+}
+
+/** \brief Get frame count.
+
+    Return the number of times display() has transferred the buffer, for frames/sec measurement.
+*/
+unsigned long MicroOLED::getFrameCount(void) {
+	return frameCount;
+}
+
+/** \brief Set frame sink.
+
+    Register a function called with the page buffer after every display(), e.g. to capture frames. Pass NULL to remove.
+*/
+void MicroOLED::setFrameSink(FrameSink sink, void *context) {
+	frameSink = sink;
+	frameSinkContext = context;
+}
+
+// One byte of a PBM raster row: 8 horizontal pixels, MSB leftmost, lit pixel = 1
+static uint8_t pbmByte(const uint8_t *screen, uint8_t xByte, uint8_t y) {
+	uint8_t b = 0;
+	for (uint8_t bit=0; bit<8; bit++) {
+		if (screen[xByte*8+bit + (y/8)*LCDWIDTH] & _BV((y%8)))
+		b |= 0x80>>bit;
+	}
+	return b;
+}
+
+/** \brief Write screen as PBM.
+
+    Write the page buffer to out as a binary (P4) PBM image. Lit pixels are 1. Consecutive images may be concatenated into one stream.
+*/
+size_t MicroOLED::writePBM(Print &out) {
+	size_t n = out.print("P4\n64 48\n");
+	for (uint8_t y=0; y<LCDHEIGHT; y++) {
+		for (uint8_t xByte=0; xByte<LCDWIDTH/8; xByte++) {
+			n += out.write(pbmByte(screenmemory, xByte, y));
+		}
+	}
+	return n;
+}
+
+#ifdef MICROOLED_HOST
+/** \brief PBM file sink.
+
+    Host frame sink appending each frame to the FILE* passed as context. Open one file per frame for stills, or keep one open for an animated sequence.
+*/
+void MicroOLED::pbmFileSink(const uint8_t *screen, void *file) {
+	FILE *f = (FILE *)file;
+	fprintf(f, "P4\n64 48\n");
+	for (uint8_t y=0; y<LCDHEIGHT; y++) {
+		for (uint8_t xByte=0; xByte<LCDWIDTH/8; xByte++) {
+			fputc(pbmByte(screen, xByte, y), f);
+		}
+	}
+	fflush(f);
+}
+#endif
+
 /** \brief Stop scrolling.
 
     Stop the scrolling of graphics on the OLED.
@@ -851,6 +958,7 @@ void MicroOLED::flipHorizontal(bool flip) {
 	}
 }
 
+#ifndef MICROOLED_HOST
 void MicroOLED::spiSetup()
 {
 	pinMode(MOSI, OUTPUT);
@@ -887,3 +995,4 @@ void MicroOLED::i2cWrite(uint8_t address, uint8_t dc, uint8_t data)
 	Wire.write(data);
 	Wire.endTransmission();
 }
+#endif
@@ -109,6 +109,9 @@ typedef enum CMD {
 	CMD_SETDRAWMODE		//18
 } commCommand_t;
 
+// Called with the 384 byte page buffer each time display() completes
+typedef void (*FrameSink)(const uint8_t *screen, void *context);
+
 typedef enum COMM_MODE{
 	MODE_SPI,
 	MODE_I2C
@@ -134,6 +137,7 @@ public:
 	void invert(bool inv);
 	void contrast(uint8_t contrast);
 	void display(void);
+	void display(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
 	void setCursor(uint8_t x, uint8_t y);
 	void pixel(uint8_t x, uint8_t y);
 	void pixel(uint8_t x, uint8_t y, uint8_t color, uint8_t mode);
@@ -160,6 +164,15 @@ public:
 	void setColor(uint8_t color);
 	void setDrawMode(uint8_t mode);
 
+	// Frame capture functions
+	uint8_t *getScreenBuffer(void);
+	unsigned long getFrameCount(void);
+	void setFrameSink(FrameSink sink, void *context);
+	size_t writePBM(Print &out);
+#ifdef MICROOLED_HOST
+	static void pbmFileSink(const uint8_t *screen, void *file);
+#endif
+
 	// Font functions
 	uint8_t getFontWidth(void);
 	uint8_t getFontHeight(void);
@@ -187,6 +200,11 @@ private:
 	uint8_t foreColor,drawMode,fontWidth, fontHeight, fontType, fontStartChar, fontTotalChar, cursorX, cursorY;
 	uint16_t fontMapWidth;
 	static const unsigned char *fontsPointer[];
+	static const unsigned char *glyphsPointer[];
+	const unsigned char *fontGlyphs;
+	FrameSink frameSink;
+	void *frameSinkContext;
+	unsigned long frameCount;
 
 	void setup(micro_oled_mode mode, uint8_t rst, uint8_t dc, uint8_t cs);
 
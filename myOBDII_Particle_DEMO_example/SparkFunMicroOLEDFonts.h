@@ -280,7 +280,7 @@ static const unsigned char font5x7[] = {
 };
 
 
-static const unsigned char font8x16[] = {
+static constexpr unsigned char font8x16[] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	8,16,32,96,2,56,
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFE, 0x00, 0x00, 0x00, 0x00,
@@ -381,7 +381,7 @@ static const unsigned char font8x16[] = {
 	0x01, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 
-static const unsigned char fontlargenumber[] = {
+static constexpr unsigned char fontlargenumber[] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	12,48,48,11,1,32,
 	0x00, 0xC0, 0xF8, 0x7C, 0x3E, 0x3E, 0xFC, 0xF8, 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xE0,
@@ -437,7 +437,7 @@ static const unsigned char fontlargenumber[] = {
 };
 
 
-static const unsigned char sevensegment [] = {
+static constexpr unsigned char sevensegment [] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	10,16,46,12,1,20,
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -457,7 +457,7 @@ static const unsigned char sevensegment [] = {
 	0xC1, 0xC1, 0xC1, 0x41, 0x3E, 0x1C, 0x00, 0x00, 0x41, 0xC1, 0xC1, 0xC1, 0xC1, 0x41, 0x3E, 0x1C
 };
 
-static const unsigned char space01[] = {
+static constexpr unsigned char space01[] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	22,16,48,2,0,44,
 	0xFC, 0xFC, 0xC0, 0xC0, 0xF3, 0xF3, 0x3C, 0x3C, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0x3C, 0x3C,
@@ -469,7 +469,7 @@ static const unsigned char space01[] = {
 };
 
 
-static const unsigned char space02[] = {
+static constexpr unsigned char space02[] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	24,16,48,2,0,48,
 	0xF0, 0xF0, 0xFC, 0xFC, 0xFC, 0xFC, 0x3C, 0x3C, 0x3F, 0x3F, 0xFF, 0xFF, 0xFF, 0xFF, 0x3F, 0x3F,
@@ -481,7 +481,7 @@ static const unsigned char space02[] = {
 };
 
 
-static const unsigned char space03[] = {
+static constexpr unsigned char space03[] = {
 	// first row defines - FONTWIDTH, FONTHEIGHT, ASCII START CHAR, TOTAL CHARACTERS, FONT MAP WIDTH HIGH, FONT MAP WIDTH LOW (2,56 meaning 256)
 	16,16,48,2,0,32,
 	0xC0, 0xC0, 0xF0, 0xF0, 0x3C, 0x3C, 0xFF, 0xFF, 0xFF, 0xFF, 0x3C, 0x3C, 0xF0, 0xF0, 0xC0, 0xC0,
@@ -490,4 +490,61 @@ static const unsigned char space03[] = {
 	0x33, 0x33, 0xCF, 0xCF, 0x03, 0x03, 0x0F, 0x0F, 0x0F, 0x0F, 0x03, 0x03, 0xCF, 0xCF, 0x33, 0x33
 };
 
+// Pre-transposed glyph atlases for the multi-page fonts, generated at compile time.
+// The fonts above are stored as a bitmap FONT MAP WIDTH columns wide per 8 pixel page;
+// an atlas holds the same bytes in SSD1306 page order:  glyph, then page, then column.
+// Glyph c starts at (c-startChar)*width*pages and each page is width contiguous bytes.
+// The bitmaps are only read at compile time.  The library points at a copy of their
+// 6 byte header and at the atlas, so the bitmaps themselves are never emitted and the
+// font data is in flash once.
+namespace fontAtlas {
+	template <unsigned... Is> struct Indices {};
+	template <class A, class B> struct Join;
+	template <unsigned... A, unsigned... B> struct Join<Indices<A...>, Indices<B...> >
+	{
+		typedef Indices<A..., (sizeof...(A)+B)...> type;
+	};
+	// 0..N-1, built by halves to keep template depth at log2(N)
+	template <unsigned N> struct MakeIndices
+	{
+		typedef typename Join<typename MakeIndices<N/2>::type, typename MakeIndices<N-N/2>::type>::type type;
+	};
+	template <> struct MakeIndices<0> { typedef Indices<> type; };
+	template <> struct MakeIndices<1> { typedef Indices<0> type; };
+
+	constexpr unsigned pages(const unsigned char *f) { return f[1]/8; }
+	constexpr unsigned mapWidth(const unsigned char *f) { return f[4]*100+f[5]; }
+	constexpr unsigned size(const unsigned char *f) { return f[3]*f[0]*pages(f); }
+	// Bitmap position of glyph g, page r, column i
+	constexpr unsigned bitmapIndex(const unsigned char *f, unsigned g, unsigned r, unsigned i)
+	{
+		return FONTHEADERSIZE + (g/(mapWidth(f)/f[0]))*mapWidth(f)*pages(f)
+			+ (g%(mapWidth(f)/f[0]))*f[0] + r*mapWidth(f) + i;
+	}
+	// Bitmap position of atlas byte k
+	constexpr unsigned sourceIndex(const unsigned char *f, unsigned k)
+	{
+		return bitmapIndex(f, k/(f[0]*pages(f)), (k/f[0])%pages(f), k%f[0]);
+	}
+
+	template <const unsigned char *F, class I> struct Atlas;
+	template <const unsigned char *F, unsigned... Is> struct Atlas<F, Indices<Is...> >
+	{
+		static constexpr unsigned char glyphs[sizeof...(Is)] = { F[sourceIndex(F, Is)]... };
+	};
+	template <const unsigned char *F, unsigned... Is>
+	constexpr unsigned char Atlas<F, Indices<Is...> >::glyphs[sizeof...(Is)];
+
+	// The header row alone
+	template <const unsigned char *F> struct Header
+	{
+		static constexpr unsigned char bytes[FONTHEADERSIZE] = {F[0], F[1], F[2], F[3], F[4], F[5]};
+	};
+	template <const unsigned char *F>
+	constexpr unsigned char Header<F>::bytes[FONTHEADERSIZE];
+}
+
+#define FONT_ATLAS(font) (fontAtlas::Atlas<font, fontAtlas::MakeIndices<fontAtlas::size(font)>::type>::glyphs)
+#define FONT_HEADER(font) (fontAtlas::Header<font>::bytes)
+
 #endif
@@ -0,0 +1,190 @@
+#include "application.h"
+#include "myDtcStats.h"
+
+// class DtcStatsBase
+// constructors
+DtcStatsBase::DtcStatsBase(DtcStat *S, const int maxSize, uint8_t *index, const int indexSize, uint32_t *dirtyBits,\
+	const bool storing, const int verbose)
+: S_(S), index_(index), dirty_(dirtyBits), maxSize_(maxSize), indexSize_(indexSize), count_(0), stored_(-1),
+	warm_(0), haveWarm_(false), coldFrom_(0), dropped_(0UL), storing_(storing), verbose_(verbose)
+{
+	memset(S_, 0, maxSize_*sizeof(DtcStat));
+	reindex();
+}
+
+// functions
+// Returns number of DTCs tracked
+int DtcStatsBase::count()
+{
+	return count_;
+}
+
+// Returns sightings of new codes lost to a full table
+unsigned long DtcStatsBase::dropped()
+{
+	return dropped_;
+}
+
+// Entry for code, -1 if not tracked
+int DtcStatsBase::find(const unsigned long cod)
+{
+	int mask = indexSize_-1;
+	for ( int i=home(cod); index_[i]!=0; i=(i+1)&mask )
+	{
+		if ( S_[index_[i]-1].code==cod ) return index_[i]-1;
+	}
+	return -1;
+}
+
+// Statistics of code, NULL if never seen
+const DtcStat *DtcStatsBase::get(const unsigned long cod)
+{
+	int e = find(cod);
+	return e<0 ? NULL : &S_[e];
+}
+
+// Statistics by entry, in order of first sighting
+const DtcStat *DtcStatsBase::getRaw(const int i)
+{
+	if ( i<0 || i>=count_ ) return NULL;
+	return &S_[i];
+}
+
+// First index slot to probe for code
+int DtcStatsBase::home(const unsigned long cod)
+{
+	uint32_t h = (uint32_t)cod*2654435761UL;  // Fibonacci hashing
+	h ^= h>>16;
+	return (int)(h & (indexSize_-1));
+}
+
+// Load table from eeprom.  Keeps the empty table if the region is not intact
+int DtcStatsBase::loadNVM(const int start)
+{
+	if ( !checkNVM(start, NVM_STATS_MAGIC, NVM_STATS_VERSION, nvmSize()-sizeof(NvmHeader)) )
+	{
+		Serial.printf("DTC stats NVM uninitialized, old format or corrupt...reinit...\n");
+		stored_ = -1;
+		coldFrom_ = count_;
+		return start + nvmSize();
+	}
+	int p = start + sizeof(NvmHeader);
+	uint16_t count; EEPROM.get(p, count); p += sizeof(uint16_t);
+	count_ = count<=maxSize_ ? count : maxSize_;
+	for ( int i=0; i<maxSize_; i++ )
+	{
+		EEPROM.get(p, S_[i]); p += sizeof(DtcStat);
+	}
+	for ( int w=0; w<(maxSize_+31)/32; w++ ) dirty_[w] = 0UL;
+	stored_ = count_;
+	coldFrom_ = count_;
+	reindex();
+	if ( verbose_>3 ) Print();
+	return p;
+}
+
+// Returns NVM footprint, bytes
+int DtcStatsBase::nvmSize()
+{
+	return sizeof(NvmHeader) + sizeof(uint16_t) + maxSize_*sizeof(DtcStat);
+}
+
+// Print table
+void DtcStatsBase::Print()
+{
+	Serial.printf("DTC   first      last       hits  cycles\n");
+	for ( int i=0; i<count_; i++ )
+		Serial.printf("P%04u %10lu %10lu %5u %3u\n", S_[i].code, S_[i].first, S_[i].last, S_[i].hits, S_[i].cycles);
+	if ( dropped_>0 ) Serial.printf("%lu sightings dropped, table full\n", dropped_);
+}
+
+// Count a sighting of code at tim
+void DtcStatsBase::record(const unsigned long tim, const unsigned long cod)
+{
+	if ( cod==0UL || cod>=0xFFFFUL ) return;
+	int e = find(cod);
+	if ( e<0 )
+	{
+		if ( count_>=maxSize_ )
+		{
+			dropped_++;
+			return;
+		}
+		e = count_++;
+		S_[e].code 		= cod;
+		S_[e].first 	= tim;
+		S_[e].hits 		= 0;
+		S_[e].cycles 	= 0;
+		S_[e].warm 		= warm_+1;  // Counts this cycle below
+		int mask = indexSize_-1;
+		int i = home(cod);
+		while ( index_[i]!=0 ) i = (i+1)&mask;
+		index_[i] = e+1;
+	}
+	S_[e].last = tim;
+	if ( S_[e].hits<0xFFFF ) S_[e].hits++;
+	if ( haveWarm_ && S_[e].warm!=warm_ )
+	{
+		S_[e].warm = warm_;
+		if ( S_[e].cycles<0xFF ) S_[e].cycles++;
+	}
+	dirty_[e>>5] |= 1UL<<(e&31);
+}
+
+// Rebuild code index from the entries
+void DtcStatsBase::reindex()
+{
+	for ( int i=0; i<indexSize_; i++ ) index_[i] = 0;
+	int mask = indexSize_-1;
+	for ( int e=0; e<count_; e++ )
+	{
+		int i = home(S_[e].code);
+		while ( index_[i]!=0 ) i = (i+1)&mask;
+		index_[i] = e+1;
+	}
+}
+
+// Store in NVM.  Puts the count and changed entries, nothing when unchanged
+int DtcStatsBase::storeNVM(const int start)
+{
+	if ( !storing_ ) return start;
+	bool any = stored_!=count_;
+	for ( int w=0; w<(maxSize_+31)/32 && !any; w++ ) any = dirty_[w]!=0UL;
+	if ( !any ) return start + nvmSize();
+	bool all = stored_<0;  // Region held something else
+	uint16_t count = count_;
+	uint32_t crc = crc32(0UL, &count, sizeof(uint16_t));
+	int p = start + sizeof(NvmHeader);
+	EEPROM.put(p, count); p += sizeof(uint16_t);
+	int nPut = 0;
+	for ( int i=0; i<maxSize_; i++ )
+	{
+		crc = crc32(crc, &S_[i], sizeof(DtcStat));
+		if ( all || dirty_[i>>5] & (1UL<<(i&31)) )
+		{
+			EEPROM.put(p, S_[i]);
+			nPut++;
+		}
+		p += sizeof(DtcStat);
+	}
+	sealNVM(start, NVM_STATS_MAGIC, NVM_STATS_VERSION, nvmSize()-sizeof(NvmHeader), crc);
+	for ( int w=0; w<(maxSize_+31)/32; w++ ) dirty_[w] = 0UL;
+	stored_ = count_;
+	if ( verbose_>3 ) Serial.printf("DTC stats stored %d of %d entries\n", nPut, count_);
+	return p;
+}
+
+// Note the current warm-up count, e.g. PID 0130.  A change starts a new cycle.
+// The first call credits this cycle to codes first seen before it
+void DtcStatsBase::warmups(const int warms)
+{
+	warm_ = (uint8_t)warms;
+	if ( haveWarm_ ) return;
+	haveWarm_ = true;
+	for ( int e=coldFrom_; e<count_; e++ )
+	{
+		S_[e].warm 		= warm_;
+		S_[e].cycles 	= 1;
+		dirty_[e>>5] |= 1UL<<(e&31);
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef _myDtcStats_h
+#define _myDtcStats_h
+
+#include "myNvm.h"
+#include "myQueue.h"  // pow2AtLeast
+
+// NVM stats format, bump version on any layout change
+#define NVM_STATS_MAGIC 	0x53435444UL  // "DTCS"
+#define NVM_STATS_VERSION 1
+
+// Lifetime statistics of one DTC, packed as stored in NVM.  Counts saturate
+struct __attribute__((packed)) DtcStat
+{
+	uint16_t code;
+	uint32_t first;     // Time first seen
+	uint32_t last;      // Time last seen
+	uint16_t hits;      // Sightings
+	uint8_t  cycles;    // Warm-up cycles it was seen in
+	uint8_t  warm;      // Warm-up count at last sighting
+};
+
+// Per-DTC statistics table.  Storage belongs to the derived DtcStats<N>.
+// Entries are dense in order of first sighting and found through a small open
+// addressed hash, so record() is constant time.  Once full, new codes are
+// counted as dropped.  storeNVM puts only entries changed since the last store.
+// Until the first warmups() the cycle is unknown, so sightings count hits only;
+// codes first seen in that time are credited with the cycle once it is known.
+class DtcStatsBase
+{
+protected:
+	DtcStat 	*S_;
+	uint8_t 	*index_;      // Entry+1, 0 empty
+	uint32_t 	*dirty_;      // Entry bits changed since last store
+	int 			maxSize_;
+	int 			indexSize_;   // Power of 2, at least 2*maxSize_
+	int 			count_;
+	int 			stored_;      // count_ in NVM
+	uint8_t 	warm_;        // Current warm-up count
+	bool 			haveWarm_;    // warm_ has been reported since boot
+	int 			coldFrom_;    // First entry added this boot, cycle counted once warm_ is known
+	unsigned long dropped_;
+	bool 			storing_;
+	int 			verbose_;
+	DtcStatsBase(DtcStat *S, const int maxSize, uint8_t *index, const int indexSize, uint32_t *dirtyBits,\
+		const bool storing, const int verbose);
+	int  find(const unsigned long cod);
+	int  home(const unsigned long cod);
+	void reindex(void);
+public:
+	int  count(void);
+	unsigned long dropped(void);
+	const DtcStat *get(const unsigned long cod);
+	const DtcStat *getRaw(const int i);
+	int  loadNVM(const int start);
+	int  nvmSize(void);
+	void Print(void);
+	void record(const unsigned long tim, const unsigned long cod);
+	int  storeNVM(const int start);
+	void warmups(const int warms);
+};
+
+// Table of N DTCs with inline storage, for static placement
+template <int N>
+class DtcStats : public DtcStatsBase
+{
+private:
+	DtcStat 	store_[N];
+	uint8_t 	codeIndex_[pow2AtLeast(2*N)];
+	uint32_t 	dirtyBits_[(N+31)/32];
+public:
+	static constexpr int capacity = N;
+	static constexpr int nvmFootprint = sizeof(NvmHeader) + sizeof(uint16_t) + N*sizeof(DtcStat);  // nvmSize() at compile time
+	DtcStats(const bool storing, const int verbose)
+	: DtcStatsBase(store_, N, codeIndex_, pow2AtLeast(2*N), dirtyBits_, storing, verbose)
+	{
+		static_assert(N>0 && N<255, "DtcStats holds 1 to 254 entries");
+	}
+};
+
+#endif
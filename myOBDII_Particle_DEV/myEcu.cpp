@@ -0,0 +1,266 @@
+#include "application.h"
+#include "myEcu.h"
+#include "mySubs.h"
+
+// class CanDemux
+// constructors
+CanDemux::CanDemux()
+: num_(0), lost_(0UL)
+{}
+
+// functions
+// Forget the previous request's messages
+void CanDemux::begin()
+{
+	num_ = 0;
+}
+
+// Copy the complete messages to out.  Returns number copied
+uint8_t CanDemux::copy(EcuLine *out, const uint8_t max)
+{
+	uint8_t n = 0;
+	for ( uint8_t i=0; i<num_ && n<max; i++ )
+		if ( msgs_[i].line.len>0 && msgs_[i].line.len>=want_[i] ) out[n++] = msgs_[i];
+	return n;
+}
+
+// One received line.  False if it is not a CAN frame, e.g. NO DATA
+bool CanDemux::frame(const char *rx)
+{
+	uint16_t n 	= strlen(rx);
+	uint8_t hdr = (n&1) ? 3 : 8;
+	if ( n<hdr+4 ) return false;  // Header, PCI and a data byte
+	char h[9];
+	char *end;
+	memcpy(h, rx, hdr);
+	h[hdr] = '\0';
+	uint32_t id = strtoul(h, &end, 16);
+	if ( end!=h+hdr ) return false;
+	// OBD responses only, 7E8..7EF or 18DAF1xx, so a line without header is not misread
+	if ( hdr==3 ? (id & 0x7F8UL)!=0x7E8UL : (id>>8)!=0x18DAF1UL ) return false;
+	ObdLine f;
+	if ( tokenize(rx+hdr, &f)!=lineData ) return false;
+
+	uint8_t i = 0;
+	while ( i<num_ && msgs_[i].id!=id ) i++;
+	if ( i==num_ )
+	{
+		if ( num_==MAX_ECUS )
+		{
+			lost_++;
+			return true;
+		}
+		num_++;
+		msgs_[i].id 				= id;
+		msgs_[i].line 			= ObdLine();
+		msgs_[i].line.kind 	= lineData;
+		want_[i] 						= 0;
+		seq_[i] 						= NO_SEQ;
+	}
+	ObdLine &m = msgs_[i].line;
+	uint8_t pci = f.bytes[0];
+	uint8_t from, take;
+	uint16_t size;
+	switch ( pci>>4 )
+	{
+		case 0:   // Single frame
+			m.len 		= 0;
+			want_[i] 	= pci & 0x0F;
+			seq_[i] 	= NO_SEQ;
+			from 			= 1;
+			break;
+		case 1:   // First frame, 12 bit length
+			m.len 		= 0;
+			size 			= (pci & 0x0F)<<8 | f.bytes[1];
+			want_[i] 	= size<OBD_BYTES ? size : OBD_BYTES;
+			seq_[i] 	= 1;
+			from 			= 2;
+			break;
+		case 2:   // Consecutive frame, numbered 1..F then 0.. after the first
+			if ( (pci & 0x0F)!=seq_[i] )
+			{
+				m.len 		= 0;    // Gap or repeat, the message cannot be trusted
+				want_[i] 	= 0;
+				seq_[i] 	= NO_SEQ;
+				return true;
+			}
+			seq_[i] 	= (seq_[i]+1) & 0x0F;
+			from 			= 1;
+			break;
+		default:  // Flow control is never sent to us
+			return true;
+	}
+	take = f.len>from ? f.len-from : 0;
+	if ( m.len+take>want_[i] ) take = want_[i]>m.len ? want_[i]-m.len : 0;
+	memcpy(m.bytes+m.len, f.bytes+from, take);
+	m.len += take;
+	return true;
+}
+
+// Returns frames dropped because MAX_ECUS had already answered
+unsigned long CanDemux::lost()
+{
+	return lost_;
+}
+
+// Complete message of the lowest ID into line, the engine ECU by convention.
+// False, line untouched, if no ECU gave a whole message
+bool CanDemux::primary(ObdLine *line)
+{
+	int best = -1;
+	for ( uint8_t i=0; i<num_; i++ )
+	{
+		if ( msgs_[i].line.len==0 || msgs_[i].line.len<want_[i] ) continue;
+		if ( best<0 || msgs_[i].id<msgs_[best].id ) best = i;
+	}
+	if ( best<0 ) return false;
+	*line = msgs_[best].line;
+	return true;
+}
+
+
+// A data line of a non-CAN protocol with ATH1:  3 header bytes, the reply and a
+// check byte, the sum of the others on ISO 9141 and KWP, a CRC on J1850.  reply
+// is the expected first byte, 0x40 plus the mode.  A J1850 PWM header starts
+// with 0x41 too, so the headed form is tried first and taken only if the check
+// byte agrees;  then a line starting with reply is plain.  Strips header and
+// check byte in place.  False, line untouched, if the line is neither
+bool CanDemux::unwrap(ObdLine *line, const uint8_t reply)
+{
+	uint8_t n = line->len;
+	if ( n>=5 && line->bytes[3]==reply )
+	{
+		uint8_t sum = 0;
+		uint8_t crc = 0xFF;   // SAE J1850:  polynomial 0x1D, inverted
+		for ( uint8_t i=0; i<n-1; i++ )
+		{
+			sum += line->bytes[i];
+			crc ^= line->bytes[i];
+			for ( uint8_t b=0; b<8; b++ ) crc = crc&0x80 ? (crc<<1)^0x1D : crc<<1;
+		}
+		if ( line->bytes[n-1]==sum || line->bytes[n-1]==(uint8_t)~crc )
+		{
+			line->len -= 4;
+			memmove(line->bytes, line->bytes+3, line->len);
+			return true;
+		}
+	}
+	return n>0 && line->bytes[0]==reply;
+}
+
+
+// class EcuSet
+// constructors
+EcuSet::EcuSet(const int verbose)
+: num_(0), verbose_(verbose)
+{}
+
+// functions
+// Returns ECUs seen
+int EcuSet::count()
+{
+	return num_;
+}
+
+// Entry of id, -1 if not seen
+int EcuSet::find(const uint32_t id)
+{
+	for ( uint8_t i=0; i<num_; i++ ) if ( ecus_[i].id==id ) return i;
+	return -1;
+}
+
+// ECU i in order of first answer, NULL past the end
+Ecu *EcuSet::get(const int i)
+{
+	return i>=0 && i<num_ ? &ecus_[i] : NULL;
+}
+
+// First PID of the next support range above the range starting at after, the
+// one last requested:  0x20 for 0120 and so on.  0 when no ECU reports a higher
+// range not yet known.  Ranges an ECU left unanswered below after are not
+// asked again, so one silent ECU does not end the chain for the others
+uint8_t EcuSet::nextRange(const uint8_t after)
+{
+	for ( uint8_t w=after/32; w<7; w++ )
+	{
+		for ( uint8_t i=0; i<num_; i++ )
+		{
+			const Ecu &e = ecus_[i];
+			// Last PID of range w, e.g. 0x20, says range w+1 exists
+			if ( (e.known & (1<<w)) && (e.pids[w] & 1UL) && !(e.known & (1<<(w+1))) ) return (w+1)*32;
+		}
+	}
+	return 0;
+}
+
+// Print each ECU with its supported PID count and codes
+void EcuSet::Print()
+{
+	for ( uint8_t i=0; i<num_; i++ )
+	{
+		Ecu &e = ecus_[i];
+		int pids = 0;
+		for ( uint8_t w=0; w<8; w++ )
+			for ( uint32_t b=e.pids[w]; b; b &= b-1 ) pids++;
+		Serial.printf("ECU %lX:  %lu answers, %d PIDs, %d codes\n", (unsigned long)e.id, e.answers, pids, e.codes.size());
+		if ( e.codes.size()>0 ) e.codes.Print();
+	}
+}
+
+// Reset every ECU's codes, as F and I are after a mode 04 clear, so a code that
+// comes back is logged again.  Returns number reset
+int EcuSet::resetCodes()
+{
+	int n = 0;
+	for ( uint8_t i=0; i<num_; i++ ) n += ecus_[i].codes.resetAll();
+	return n;
+}
+
+// True if any ECU supports mode 01 pid, or if support is not known yet
+bool EcuSet::supported(const uint8_t pid)
+{
+	if ( pid==0 ) return true;
+	uint8_t w 		= (pid-1)/32;
+	uint32_t bit 	= 1UL<<(31-(pid-1)%32);
+	bool known 		= false;
+	for ( uint8_t i=0; i<num_; i++ )
+	{
+		if ( !(ecus_[i].known & (1<<w)) ) continue;
+		known = true;
+		if ( ecus_[i].pids[w] & bit ) return true;
+	}
+	return !known;
+}
+
+// Learn from the messages of one request:  PID support ranges from mode 01
+// PIDs 00, 20 .. E0 and codes from modes 03 and 07.  faultTime 0 skips codes
+void EcuSet::take(const EcuLine *msgs, const uint8_t n, const unsigned long faultTime)
+{
+	for ( uint8_t k=0; k<n; k++ )
+	{
+		int i = find(msgs[k].id);
+		if ( i<0 )
+		{
+			if ( num_==MAX_ECUS ) continue;
+			i = num_++;
+			ecus_[i].id = msgs[k].id;
+			if ( verbose_>2 ) Serial.printf("ECU %lX answered\n", (unsigned long)msgs[k].id);
+		}
+		Ecu &e = ecus_[i];
+		e.answers++;
+		ByteSpan b = msgs[k].line.span();
+		if ( b[0]==0x41 && (b[1]&0x1F)==0 && b.len>=6 )
+		{
+			uint8_t w = b[1]/32;
+			e.pids[w] = (uint32_t)b.word(2)<<16 | b.word(4);
+			e.known 	|= 1<<w;
+		}
+		else if ( (b[0]==0x43 || b[0]==0x47) && faultTime>0 )
+		{
+			unsigned long codes[100];   // parseCodes takes up to 100
+			uint8_t ncodes;
+			int found = parseCodes(b, codes, &ncodes);
+			for ( int c=0; c<found; c++ ) e.codes.newCode(faultTime, codes[c]);
+		}
+	}
+}
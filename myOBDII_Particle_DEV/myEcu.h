@@ -0,0 +1,86 @@
+#ifndef _myEcu_h
+#define _myEcu_h
+
+#include <stdint.h>
+#include "myQueue.h"
+#include "myResponse.h"
+
+// Usually defined.  Comment out for adapters that do not take ATH1; replies
+// are then read as a single line from one ECU.  Non-CAN protocols work either
+// way:  a request that brings no CAN frame is read as a headed K-line or J1850 line.
+#define OBD_HEADERS
+
+#define MAX_ECUS 		4     // ECUs told apart per request
+#define ECU_CODES 	16    // Codes kept per ECU, RAM
+#define OBD_LINES 	16    // Received lines read per request, frames and status
+#define NO_SEQ 			0x10  // CanDemux:  no consecutive frame expected
+
+// Whole message from one ECU:  its CAN ID and the reassembled data bytes
+class EcuLine
+{
+public:
+	uint32_t 	id;           // 7E8.. for 11 bit, 18DAF1xx for 29 bit
+	ObdLine 	line;
+	EcuLine(void) : id(0UL) {}
+};
+
+// I/O side.  Splits ATH1 lines into header and ISO 15765 frame, and reassembles
+// single, first and consecutive frames into a buffer per ECU.  A consecutive frame
+// out of sequence, lost or repeated, discards that ECU's message.  getResponse drops
+// the spaces, so an 11 bit header leaves an odd number of hex characters and a
+// 29 bit header an even number.  A line that is not a CAN frame comes from a
+// non-CAN protocol, and unwrap() turns it back into a plain reply.
+class CanDemux
+{
+private:
+	EcuLine 			msgs_[MAX_ECUS];
+	uint8_t 			want_[MAX_ECUS];  // Message length from the first frame
+	uint8_t 			seq_[MAX_ECUS];   // Next consecutive frame number, NO_SEQ if none due
+	uint8_t 			num_;
+	unsigned long lost_;            // Frames from ECUs past MAX_ECUS
+public:
+	CanDemux(void);
+	void begin(void);
+	uint8_t copy(EcuLine *out, const uint8_t max);
+	bool frame(const char *rx);
+	unsigned long lost(void);
+	bool primary(ObdLine *line);
+	static bool unwrap(ObdLine *line, const uint8_t reply);
+};
+
+// One ECU as learned from its replies
+class Ecu
+{
+public:
+	uint32_t 				id;
+	uint32_t 				pids[8];    // Mode 01 support.  Bit 31 of word w is PID 32*w+1
+	uint8_t 				known;      // Bit per word reported
+	unsigned long 	answers;
+	Queue<ECU_CODES> codes;     // Mode 03 and 07 codes it reported
+	Ecu(void) : id(0UL), known(0), answers(0UL), codes(0, "ECU", false, 0)
+	{
+		for ( uint8_t w=0; w<8; w++ ) pids[w] = 0UL;
+	}
+};
+
+// UI side.  Every ECU that has answered, with its PID support bitmaps and codes,
+// so one request serves all of them and unsupported PIDs are not guessed at.
+class EcuSet
+{
+private:
+	Ecu 					ecus_[MAX_ECUS];
+	uint8_t 			num_;
+	int 					verbose_;
+	int  find(const uint32_t id);
+public:
+	EcuSet(const int verbose);
+	int  count(void);
+	Ecu *get(const int i);
+	uint8_t nextRange(const uint8_t after);
+	void Print(void);
+	int  resetCodes(void);
+	bool supported(const uint8_t pid);
+	void take(const EcuLine *msgs, const uint8_t n, const unsigned long faultTime);
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "application.h"
+#include "myFormat.h"
+
+// Decimal digits of the largest unsigned long, with a little to spare:  10 on
+// the Photon, 20 on a 64 bit host
+#define ULONG_DIGITS (3*sizeof(unsigned long))
+
+// class TextBuf
+// functions
+// Append string
+TextBuf& TextBuf::add(const char *s)
+{
+	while ( *s && len_<cap_ ) buf_[len_++] = *s++;
+	buf_[len_] = '\0';
+	return *this;
+}
+
+// Append character
+TextBuf& TextBuf::add(const char c)
+{
+	if ( len_<cap_ ) buf_[len_++] = c;
+	buf_[len_] = '\0';
+	return *this;
+}
+
+// Append v/10^decimals with decimal point, right aligned to width, like %width.decimalsf.
+// decimals is limited to what an unsigned long can scale by
+TextBuf& TextBuf::addFixed(const long v, const uint8_t decimals, const uint8_t width)
+{
+	const uint8_t places = decimals<ULONG_DIGITS/3*2 ? decimals : ULONG_DIGITS/3*2;
+	unsigned long scale = 1UL;
+	for ( uint8_t i=0; i<places; i++ ) scale *= 10UL;
+	unsigned long mag = v<0 ? -(unsigned long)v : v;
+	char tmp[ULONG_DIGITS+2];   // Digits, point and sign
+	uint8_t n = 0;
+	unsigned long frac = mag%scale;
+	for ( uint8_t i=0; i<places; i++ )
+	{
+		tmp[n++] = '0' + frac%10UL;
+		frac /= 10UL;
+	}
+	if ( places>0 ) tmp[n++] = '.';
+	mag /= scale;
+	do
+	{
+		tmp[n++] = '0' + mag%10UL;
+		mag /= 10UL;
+	} while ( mag>0 );
+	if ( v<0 ) tmp[n++] = '-';
+	for ( uint8_t i=n; i<width; i++ ) add(' ');
+	while ( n>0 ) add(tmp[--n]);
+	return *this;
+}
+
+// Append signed integer right aligned to width, like %widthd or %0widthd
+TextBuf& TextBuf::addInt(const long v, const uint8_t width, const char pad)
+{
+	if ( v>=0 ) return addUns(v, width, pad);
+	if ( pad=='0' )
+	{
+		add('-');
+		return addUns(-(unsigned long)v, width>0 ? width-1 : 0, pad);
+	}
+	char tmp[ULONG_DIGITS+1];   // Digits and sign
+	uint8_t n = 0;
+	unsigned long mag = -(unsigned long)v;
+	do
+	{
+		tmp[n++] = '0' + mag%10UL;
+		mag /= 10UL;
+	} while ( mag>0 );
+	tmp[n++] = '-';
+	for ( uint8_t i=n; i<width; i++ ) add(pad);
+	while ( n>0 ) add(tmp[--n]);
+	return *this;
+}
+
+// Append unsigned integer right aligned to width, like %widthu or %0widthu
+TextBuf& TextBuf::addUns(const unsigned long v, const uint8_t width, const char pad)
+{
+	char tmp[ULONG_DIGITS];
+	uint8_t n = 0;
+	unsigned long mag = v;
+	do
+	{
+		tmp[n++] = '0' + mag%10UL;
+		mag /= 10UL;
+	} while ( mag>0 );
+	for ( uint8_t i=n; i<width; i++ ) add(pad);
+	while ( n>0 ) add(tmp[--n]);
+	return *this;
+}
+
+// Integer division rounded to nearest, halves away from zero
+long divRound(const long num, const long den)
+{
+	if ( (num<0) != (den<0) ) return (num - den/2)/den;
+	return (num + den/2)/den;
+}
@@ -0,0 +1,56 @@
+#ifndef _myFormat_h
+#define _myFormat_h
+
+#include <stdint.h>
+
+// Heap-free text buffer.  Storage belongs to the derived FixedText; appends past
+// capacity are truncated so the buffer is always null terminated.
+class TextBuf
+{
+protected:
+	char 		*buf_;
+	uint8_t cap_;
+	uint8_t len_;
+	TextBuf(char *buf, const uint8_t cap)
+	: buf_(buf), cap_(cap), len_(0)
+	{
+		buf_[0] = '\0';
+	}
+public:
+	TextBuf& add(const char *s);
+	TextBuf& add(const char c);
+	TextBuf& addFixed(const long v, const uint8_t decimals, const uint8_t width=0);
+	TextBuf& addInt(const long v, const uint8_t width=0, const char pad=' ');
+	TextBuf& addUns(const unsigned long v, const uint8_t width=0, const char pad=' ');
+	const char *c_str(void) const { return buf_; }
+	void clear(void)	{ len_ = 0; buf_[0] = '\0'; }
+	uint8_t length(void) const { return len_; }
+	operator const char *() const { return buf_; }
+};
+
+// TextBuf with N characters of inline storage
+template <uint8_t N>
+class FixedText : public TextBuf
+{
+private:
+	char store_[N+1];
+public:
+	FixedText(void) : TextBuf(store_, N) {}
+	FixedText(const char *s) : TextBuf(store_, N) { add(s); }
+	FixedText(const FixedText &T) : TextBuf(store_, N) { add(T.c_str()); }
+	FixedText& operator=(const FixedText &T)
+	{
+		if ( this!=&T ) { clear(); add(T.c_str()); }
+		return *this;
+	}
+	FixedText& operator=(const char *s)
+	{
+		clear(); add(s);
+		return *this;
+	}
+};
+
+// Integer division rounded to nearest, halves away from zero
+long divRound(const long num, const long den);
+
+#endif
@@ -0,0 +1,144 @@
+#include "application.h"
+#include "myFreeze.h"
+
+// Mode 02 requests for frame 0 and where their data bytes go.  PID 02 fills cause
+static const struct
+{
+	const char 	*cmd;
+	uint8_t 		pid;
+	uint8_t 		bytes;
+	int8_t 			at;         // In FreezeFrame::data, -1 for cause
+} freezePids[FREEZE_PIDS] = {
+	{"020200", 0x02, 2, -1},
+	{"020400", 0x04, 1,  0},    // Load, A*100/255 %
+	{"020500", 0x05, 1,  1},    // Coolant, A-40 C
+	{"020C00", 0x0C, 2,  2},    // rpm, (A*256+B)/4
+	{"020D00", 0x0D, 1,  4},    // Speed, kph
+	{"021100", 0x11, 2,  5},    // Throttle, A*100/255 %.  B spare
+};
+
+// class FreezeFramesBase
+// constructors
+FreezeFramesBase::FreezeFramesBase(FreezeFrame *F, const int maxSize, const int verbose)
+: F_(F), maxSize_(maxSize), count_(0), next_(0), capturing_(-1), waiting_(0), captured_(0UL), verbose_(verbose)
+{}
+
+// functions
+// Start capturing the oldest pending frame.  Returns number of requests to
+// submit, cmd(0) to cmd(n-1), or 0 if none pending or a capture is in flight
+int FreezeFramesBase::begin()
+{
+	if ( capturing_>=0 ) return 0;
+	for ( int i=0; i<count_; i++ )
+	{
+		if ( F_[i].state!=FREEZE_PENDING ) continue;
+		F_[i].state = FREEZE_CAPTURING;
+		capturing_ 	= i;
+		waiting_ 		= FREEZE_PIDS;
+		return FREEZE_PIDS;
+	}
+	return 0;
+}
+
+// Request i of a capture batch
+const char *FreezeFramesBase::cmd(const int i)
+{
+	return i>=0 && i<FREEZE_PIDS ? freezePids[i].cmd : "";
+}
+
+// Returns frames held
+int FreezeFramesBase::count()
+{
+	return count_;
+}
+
+// Slot holding code, -1 if none
+int FreezeFramesBase::find(const unsigned long cod)
+{
+	for ( int i=0; i<count_; i++ ) if ( F_[i].code==cod ) return i;
+	return -1;
+}
+
+// Frame of code, NULL if never triggered
+const FreezeFrame *FreezeFramesBase::get(const unsigned long cod)
+{
+	int i = find(cod);
+	return i<0 ? NULL : &F_[i];
+}
+
+// True if a frame waits for the bus
+bool FreezeFramesBase::pending()
+{
+	for ( int i=0; i<count_; i++ ) if ( F_[i].state==FREEZE_PENDING ) return true;
+	return false;
+}
+
+// Print decoded frames, missing values as -
+void FreezeFramesBase::Print()
+{
+	Serial.printf("Freeze  cause  load  cool   rpm  kph  thr\n");
+	for ( int i=0; i<count_; i++ )
+	{
+		const FreezeFrame &f = F_[i];
+		const uint8_t *d = f.data;
+		Serial.printf("P%04u  ", (unsigned)f.code);
+		if ( f.have & 0x01 ) Serial.printf("%04X  ", f.cause); else Serial.printf("   -  ");
+		if ( f.have & 0x02 ) Serial.printf("%4u", d[0]*100/255); else Serial.printf("   -");
+		if ( f.have & 0x04 ) Serial.printf("%6d", d[1]-40); else Serial.printf("     -");
+		if ( f.have & 0x08 ) Serial.printf("%6u", (d[2]*256+d[3])/4); else Serial.printf("     -");
+		if ( f.have & 0x10 ) Serial.printf("%5u", d[4]); else Serial.printf("    -");
+		if ( f.have & 0x20 ) Serial.printf("%5u", d[5]*100/255); else Serial.printf("    -");
+		Serial.printf("%s\n", f.state==FREEZE_DONE ? "" : f.state==FREEZE_PENDING ? "  (pending)" : "  (capturing)");
+	}
+	Serial.printf("%lu frames captured\n", captured_);
+}
+
+// One reply of the capture in flight.  resp is the whole line, 42 PID 00 data
+void FreezeFramesBase::take(const char *cmd, const bool ok, const ByteSpan resp)
+{
+	if ( capturing_<0 ) return;
+	FreezeFrame &f = F_[capturing_];
+	for ( uint8_t p=0; p<FREEZE_PIDS; p++ )
+	{
+		if ( strcmp(cmd, freezePids[p].cmd)!=0 ) continue;
+		if ( ok && resp[0]==0x42 && resp[1]==freezePids[p].pid && resp.len>=3+freezePids[p].bytes )
+		{
+			ByteSpan A = resp.from(3);
+			if ( freezePids[p].at<0 ) f.cause = A.word(0);
+			else for ( uint8_t b=0; b<freezePids[p].bytes; b++ ) f.data[freezePids[p].at+b] = A[b];
+			f.have |= 1<<p;
+		}
+		break;
+	}
+	if ( waiting_>0 && --waiting_==0 )
+	{
+		f.state 		= FREEZE_DONE;
+		capturing_ 	= -1;
+		captured_++;
+		if ( verbose_>2 ) Print();
+	}
+}
+
+// Newly logged fault:  queue a capture.  A code logged again after a reset
+// re-arms its slot, so the frame is of this occurrence and not the first
+void FreezeFramesBase::trigger(const unsigned long tim, const unsigned long cod)
+{
+	int i = find(cod);
+	if ( i>=0 && i==capturing_ )
+	{
+		F_[i].time = tim;   // Requests already in flight, taken now
+		return;
+	}
+	if ( i<0 && count_<maxSize_ ) i = count_++;
+	else if ( i<0 )
+	{
+		i = next_;
+		if ( i==capturing_ ) i = (i+1)%maxSize_;  // Keep the capture in flight
+		next_ = (i+1)%maxSize_;
+	}
+	memset(&F_[i], 0, sizeof(FreezeFrame));
+	F_[i].time 	= tim;
+	F_[i].code 	= cod;
+	F_[i].state = FREEZE_PENDING;
+	if ( verbose_>3 ) Serial.printf("Freeze frame queued for P%04lu\n", cod);
+}
@@ -0,0 +1,71 @@
+#ifndef _myFreeze_h
+#define _myFreeze_h
+
+#include <stdint.h>
+#include "myResponse.h"
+
+#define FREEZE_PIDS 	6     // Mode 02 PIDs captured per frame
+#define FREEZE_BYTES 	7     // Their data bytes, after PID 02
+
+// Freeze frame of one fault, compact:  PID 02 cause then load, coolant, rpm,
+// speed and throttle as the raw mode 02 data bytes, 17 bytes in all
+#define FREEZE_PENDING 		0   // state:  waiting for the bus
+#define FREEZE_CAPTURING 	1   // Requests in flight
+#define FREEZE_DONE 			2
+struct __attribute__((packed)) FreezeFrame
+{
+	uint32_t time;      // Fault last logged
+	uint16_t code;      // Fault as logged, e.g. 133 for P0133
+	uint16_t cause;     // Fault the ECU stored its frame for, PID 02, raw
+	uint8_t  have;      // Bits of the PIDs answered
+	uint8_t  state;
+	uint8_t  data[FREEZE_BYTES];
+};
+static_assert(sizeof(FreezeFrame)==17, "FreezeFrame layout changed, update its size above");
+
+// Freeze frames keyed by fault code.  Storage belongs to the derived
+// FreezeFrames<N>.  A queue attached with QueueBase::attach calls trigger() for
+// each newly logged fault, and again when a reset fault recurs;  the caller's
+// loop later runs begin() when the bus is free, submits the returned batch of
+// mode 02 requests and feeds each reply to take().  Nothing here blocks, so
+// capture rides along with normal sampling.  Once full, the oldest frame is
+// recycled.
+class FreezeFramesBase
+{
+protected:
+	FreezeFrame 	*F_;
+	int 					maxSize_;
+	int 					count_;
+	int 					next_;        // Slot to recycle when full
+	int 					capturing_;   // Slot with requests in flight, -1 none
+	uint8_t 			waiting_;     // Replies still due
+	unsigned long captured_;
+	int 					verbose_;
+	FreezeFramesBase(FreezeFrame *F, const int maxSize, const int verbose);
+	int  find(const unsigned long cod);
+public:
+	int  begin(void);
+	static const char *cmd(const int i);
+	int  count(void);
+	const FreezeFrame *get(const unsigned long cod);
+	bool pending(void);
+	void Print(void);
+	void take(const char *cmd, const bool ok, const ByteSpan resp);
+	void trigger(const unsigned long tim, const unsigned long cod);
+};
+
+// N frames with inline storage
+template <int N>
+class FreezeFrames : public FreezeFramesBase
+{
+private:
+	FreezeFrame store_[N];
+public:
+	FreezeFrames(const int verbose)
+	: FreezeFramesBase(store_, N, verbose)
+	{
+		static_assert(N>0, "FreezeFrames holds at least 1 frame");
+	}
+};
+
+#endif
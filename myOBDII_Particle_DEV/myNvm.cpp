@@ -0,0 +1,144 @@
+#include "application.h"
+#include "myNvm.h"
+
+// CRC32 in nibble steps, 64 byte table
+static const uint32_t crcNibble[16] = {
+	0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+	0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL};
+
+// Fold one byte into a running (inverted) CRC
+static uint32_t crc32Byte(uint32_t c, const uint8_t b)
+{
+	c ^= b;
+	c = (c>>4) ^ crcNibble[c & 0x0F];
+	c = (c>>4) ^ crcNibble[c & 0x0F];
+	return c;
+}
+
+// CRC32 of n bytes, continuing from crc
+uint32_t crc32(const uint32_t crc, const void *data, const size_t n)
+{
+	const uint8_t *b = (const uint8_t *)data;
+	uint32_t c = ~crc;
+	for ( size_t i=0; i<n; i++ ) c = crc32Byte(c, b[i]);
+	return ~c;
+}
+
+// CRC32 of n EEPROM bytes from start
+uint32_t crc32NVM(const int start, const int n)
+{
+	uint32_t c = 0xFFFFFFFFUL;
+	for ( int i=0; i<n; i++ ) c = crc32Byte(c, EEPROM.read(start+i));
+	return ~c;
+}
+
+// True if region at start is intact and of the expected format
+bool checkNVM(const int start, const uint32_t magic, const uint16_t version, const uint16_t length)
+{
+	NvmHeader H;
+	EEPROM.get(start, H);
+	if ( H.magic!=magic || H.version!=version || H.length!=length ) return false;
+	return H.crc==crc32NVM(start+sizeof(NvmHeader), length);
+}
+
+// Write header for body already stored
+void sealNVM(const int start, const uint32_t magic, const uint16_t version, const uint16_t length, const uint32_t crc)
+{
+	NvmHeader H;
+	H.magic 	= magic;
+	H.version = version;
+	H.length 	= length;
+	H.crc 		= crc;
+	EEPROM.put(start, H);
+}
+
+
+// class NvmMap
+// constructors
+NvmMap::NvmMap(const int length, const int verbose)
+: count_(0), length_(length), next_(nvmDirSize), verbose_(verbose)
+{
+	memset(dir_, 0, sizeof(dir_));
+	for ( int i=0; i<NVM_REGIONS; i++ ) kept_[i] = false;
+}
+
+// functions
+// Reserve the next size bytes under name.  Returns region id, -1 if out of room
+int NvmMap::add(const char *name, const int size)
+{
+	if ( count_>=NVM_REGIONS || size<=0 || next_+size>length_ ) return -1;
+	strncpy(dir_[count_].name, name, NVM_NAME-1);
+	dir_[count_].name[NVM_NAME-1] = '\0';
+	dir_[count_].start 	= next_;
+	dir_[count_].size 	= size;
+	next_ += size;
+	return count_++;
+}
+
+// Compare stored directory with this layout and store it if changed.  Returns
+// number of regions kept
+int NvmMap::begin()
+{
+	NvmHeader H;
+	EEPROM.get(0, H);
+	int nOld = H.length/sizeof(NvmRegion);
+	bool valid = H.magic==NVM_DIR_MAGIC && H.version==NVM_DIR_VERSION && H.length%sizeof(NvmRegion)==0 &&\
+		nOld<=NVM_REGIONS && H.crc==crc32NVM(sizeof(NvmHeader), H.length);
+	int nKept = 0;
+	for ( int i=0; i<count_; i++ )
+	{
+		kept_[i] = false;
+		for ( int j=0; valid && j<nOld && !kept_[i]; j++ )
+		{
+			NvmRegion R;
+			EEPROM.get(sizeof(NvmHeader)+j*sizeof(NvmRegion), R);
+			kept_[i] = !strncmp(R.name, dir_[i].name, NVM_NAME) && R.start==dir_[i].start && R.size==dir_[i].size;
+		}
+		if ( kept_[i] ) nKept++;
+	}
+	if ( !valid || nOld!=count_ || nKept!=count_ )
+	{
+		int length = count_*sizeof(NvmRegion);
+		for ( int i=0; i<count_; i++ ) EEPROM.put(sizeof(NvmHeader)+i*sizeof(NvmRegion), dir_[i]);
+		sealNVM(0, NVM_DIR_MAGIC, NVM_DIR_VERSION, length, crc32(0UL, dir_, length));
+		if ( verbose_>0 ) Serial.printf("NVM layout changed, %d of %d regions kept\n", nKept, count_);
+	}
+	if ( verbose_>3 ) Print();
+	return nKept;
+}
+
+// True if region id has the same place as in the stored directory
+bool NvmMap::kept(const int id)
+{
+	if ( id<0 || id>=count_ ) return false;
+	return kept_[id];
+}
+
+// Returns region name
+const char *NvmMap::name(const int id)
+{
+	if ( id<0 || id>=count_ ) return "";
+	return dir_[id].name;
+}
+
+// Print directory
+void NvmMap::Print()
+{
+	Serial.printf("NVM %d of %d bytes used\n", next_, length_);
+	for ( int i=0; i<count_; i++ )
+		Serial.printf("  %-8s %4u %4u %s\n", dir_[i].name, dir_[i].start, dir_[i].size, kept_[i] ? "kept" : "new");
+}
+
+// Returns region size, bytes
+int NvmMap::size(const int id)
+{
+	if ( id<0 || id>=count_ ) return 0;
+	return dir_[id].size;
+}
+
+// Returns region start, -1 if unknown
+int NvmMap::start(const int id)
+{
+	if ( id<0 || id>=count_ ) return -1;
+	return dir_[id].start;
+}
@@ -0,0 +1,78 @@
+#ifndef _myNvm_h
+#define _myNvm_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Header in front of each persisted region.  length bytes of body follow and
+// crc is CRC32 of the body, so one streaming pass validates it.  Written after
+// the body, so a torn write fails the check.
+struct __attribute__((packed)) NvmHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t length;
+	uint32_t crc;
+};
+
+// CRC32 (IEEE, reflected) of n bytes, continuing from crc.  Start with 0
+uint32_t crc32(const uint32_t crc, const void *data, const size_t n);
+
+// CRC32 of n EEPROM bytes from start
+uint32_t crc32NVM(const int start, const int n);
+
+// True if the header at start has magic, version and length and its body matches crc
+bool checkNVM(const int start, const uint32_t magic, const uint16_t version, const uint16_t length);
+
+// Write header for the length bytes of body already stored after it.  crc is of
+// the intended body, so a bad EEPROM write is caught at the next check
+void sealNVM(const int start, const uint32_t magic, const uint16_t version, const uint16_t length, const uint32_t crc);
+
+// Directory of named fixed regions, kept at the start of EEPROM.  Regions are
+// laid out after it in the order added.  begin() compares the stored directory
+// with this build's layout.  A region that kept its name, start and size holds
+// its old data.  A moved or resized region must be reinitialized by its owner.
+#define NVM_REGIONS 		8           // Directory entries
+#define NVM_NAME 				8           // Region name incl terminator
+#define NVM_DIR_MAGIC 	0x5249444EUL  // "NDIR"
+#define NVM_DIR_VERSION 1
+struct __attribute__((packed)) NvmRegion
+{
+	char 			name[NVM_NAME];
+	uint16_t 	start;
+	uint16_t 	size;
+};
+constexpr int nvmDirSize = sizeof(NvmHeader) + NVM_REGIONS*sizeof(NvmRegion);
+
+// Bytes needed for the directory and regions of the listed sizes, for static_assert
+constexpr int nvmBudget(const int size)
+{
+	return nvmDirSize + size;
+}
+template <typename... Sizes>
+constexpr int nvmBudget(const int size, Sizes... more)
+{
+	return size + nvmBudget(more...);
+}
+
+class NvmMap
+{
+private:
+	NvmRegion dir_[NVM_REGIONS];
+	bool 			kept_[NVM_REGIONS];
+	int 			count_;
+	int 			length_;    // EEPROM bytes
+	int 			next_;      // Start of next region
+	int 			verbose_;
+public:
+	NvmMap(const int length, const int verbose);
+	int  add(const char *name, const int size);
+	int  begin(void);
+	bool kept(const int id);
+	const char *name(const int id);
+	void Print(void);
+	int  size(const int id);
+	int  start(const int id);
+};
+
+#endif
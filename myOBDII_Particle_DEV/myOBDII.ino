@@ -25,11 +25,24 @@ See README.md
 SYSTEM_THREAD(ENABLED);      // Make sure heat system code always run regardless of network status
 #include "myQueue.h"
 #include "mySubs.h"
+#include "myScreens.h"
+#include "myFormat.h"
+#include "myWidgets.h"
+#include "myNvm.h"
+#include "myDtcStats.h"
+#include "myScheduler.h"
+#include "myObdIo.h"
+#include "myPids.h"
+#include "myPidStats.h"
+#include "myTsLog.h"
+#include "myFreeze.h"
+#include "myReadiness.h"
+#include "myEcu.h"
 
 //
 // Test features
 bool              jumper            = false;    // not using jumper
-extern int        verbose           = 5;        // Debugging Serial.print as much as you can tolerate.  0=none
+int               verbose           = 5;        // Debugging Serial.print as much as you can tolerate.  0=none
 bool              clearNVM          = false;    // Command to reset NVM on fresh load
 bool              NVM_StoreAllowed  = false;    // Allow storing jumper faults
 bool              ignoring          = true;    // Ignore jumper faults
@@ -41,12 +54,27 @@ bool              ignoring          = true;    // Ignore jumper faults
 // #define USUALLY
 
 // Constants always defined
-#define MAX_SIZE 30  //maximum size of the array that will store Queue.
-// Caution:::do not exceed about 30 for two code quees
+#define MAX_SIZE 60  //maximum size of the array that will store Queue.  NVM use is Queue<MAX_SIZE, MAX_JOURNAL>::nvmFootprint, see nvmBudget below
+#define MAX_JOURNAL 8 // NVM journal slots per Queue, a snapshot every 8 changes.  Leaves room for LOG_NVM_PAGES
+#define NVM_SIZE 2047 // Photon emulated EEPROM.length()
+#define MAX_DTCS 16   // Distinct DTCs with lifetime statistics
+#define MAX_FRAMES 8  // Freeze frames kept, RAM
+#define FREEZE_DELAY 			1000UL 		  // Freeze frame capture poll period
 #define DISPLAY_DELAY 		30000UL 		// Fault code display period
 #define READ_DELAY 				30000UL 		// Fault code reading period
 #define RESET_DELAY 			90000UL 		// Fault reset period
 #define SAMPLING_DELAY		5000UL 		  // Data sampling period
+#define LIVE_DWELL 				20000UL 		// Live data screen dwell
+#define ACTIVE_DWELL 			5000UL 		  // Active faults screen dwell
+#define STORED_DWELL 			5000UL 		  // Stored faults screen dwell
+#define STATUS_DWELL 			3000UL 		  // Status screen dwell
+#define TREND_DWELL 			15000UL 		// Trend screen dwell
+#define STATS_DWELL 			5000UL 		  // Statistics screen dwell
+#define LOG_DELAY 				1000UL 		  // Time series log row period
+#define LOG_PAGES 				48 					// Log pages of LOG_PAGE bytes, RAM
+#define LOG_PAGE 					256 					// Sealed as a batch, as a flash page would be
+#define LOG_NVM_PAGES 		2 					// Newest sealed log pages also in NVM, stored by taskReset.  About 10 kB an hour of driving
+#define TREND_DELAY 			250UL 		  // RPM trace sampling period while trend on show
 
 // Dependent includes.   Easier to debug code if remove unused include files
 #include "SparkFunMicroOLED.h"  // Include MicroOLED library
@@ -55,29 +83,31 @@ bool              ignoring          = true;    // Ignore jumper faults
 
 // Global variables
 unsigned long      activeCode[MAX_SIZE];
-/*                     Test enabled	Test incomplete
-Empty                  A0-A7
-Reserved	             B3	           B7
-Components	           B2	           B6
-Fuel System	           B1	           B5
-Misfire	               B0	           B4
-EGR System	           C7	           D7
-Oxygen Sensor Heater	 C6	           D6
-Oxygen Sensor	         C5	          D5
-A/C Refrigerant	      C4	           D4
-Secondary Air System	C3	          D3
-Evaporative System	  C2	          D2
-Heated Catalyst	      C1	         D1
-Catalyst	           C0	           D0
-*/
+FixedText<20>     adapterId;                  // ATZ response
+std::atomic<unsigned long> busMicros(0UL);    // Time spent in UART transactions, us.  Added to by the I/O thread
+int               busUtil       = 0;          // Time in UART transactions, 0.1 percent
 int               coolantTemp   = 0;          // Coolant temp -40 to 215 C
 unsigned long     codes[MAX_SIZE];
-Queue*            F;                          // Faults
-Queue*            I;                          // Impending faults
-const int         faultNVM 			= 1; 					// NVM location
 const int         GMT 					= -5; 				// Greenwich mean time adjustment, hrs
-int               impendNVM;  								// NVM locations, calculated
+Queue<MAX_SIZE, MAX_JOURNAL> F(GMT, "FAULTS",    (!jumper||NVM_StoreAllowed), verbose);  // Faults
+Queue<MAX_SIZE, MAX_JOURNAL> I(GMT, "IMPENDING", (!jumper||NVM_StoreAllowed), verbose);  // Impending faults
+DtcStats<MAX_DTCS> stats((!jumper||NVM_StoreAllowed), verbose);  // First, last seen, hits, warm-up cycles
+FreezeFrames<MAX_FRAMES> frames(verbose);     // Mode 02 conditions of new confirmed faults
+static_assert(nvmBudget(Queue<MAX_SIZE, MAX_JOURNAL>::nvmFootprint, Queue<MAX_SIZE, MAX_JOURNAL>::nvmFootprint,\
+  DtcStats<MAX_DTCS>::nvmFootprint, TsLog<LOG_PAGES, LOG_PAGE, 3, LOG_NVM_PAGES>::nvmFootprint)<=NVM_SIZE,\
+  "NVM regions exceed EEPROM, reduce MAX_SIZE, MAX_JOURNAL, MAX_DTCS or LOG_NVM_PAGES");
+NvmMap            nvm(NVM_SIZE, verbose);     // Named NVM regions
+const int         faultNVM      = nvm.add("FAULTS", Queue<MAX_SIZE, MAX_JOURNAL>::nvmFootprint);
+const int         impendNVM     = nvm.add("IMPEND", Queue<MAX_SIZE, MAX_JOURNAL>::nvmFootprint);
+const int         statsNVM      = nvm.add("STATS",  DtcStats<MAX_DTCS>::nvmFootprint);
+const int         logNVM        = nvm.add("TSLOG",  TsLog<LOG_PAGES, LOG_PAGE, 3, LOG_NVM_PAGES>::nvmFootprint);
 MicroOLED         oled;
+Compositor        screens(&oled, verbose);    // Non-blocking screen rotation
+int               liveScreen, activeScreen, storedScreen, statusScreen, trendScreen;
+Scheduler         tasks(verbose);             // Periodic work in loop()
+BarGauge          speedGauge(&oled, 0, 0, 64, 8, 0, 200);   // kph, recent min/max ticks below
+Sparkline         rpmTrace(&oled, 0, 16, 64, 32, 0, 7000);  // rpm
+bool              liveOk[6];                  // Last ping of each live value succeeded
 uint8_t           ncodes        = 0;          // Number of fault codes
 unsigned long     pendingCode[MAX_SIZE];
 char              rxData[4*101];
@@ -86,8 +116,25 @@ int               warmsSinceRes = 0;          // 255
 int               kmSinceRes    = 0;          // km 65535
 int               vehicleSpeed  = 0;          // kph 255
 int               vehicleRPM    = 0;          // rpm 16383
+Readiness         readiness(readyChange);     // 0101 monitors, MIL and DTC count
+EcuSet            ecus(verbose);              // Every ECU that answers, its PIDs and codes
+enum LiveLine     : uint8_t {speedLine, rpmLine, warmsLine, kmLine, coolantLine, readyLine};
+enum ReplyTag     : uint8_t {confirmedTag=readyLine+1, pendingTag, resetTag, trendTag, freezeTag, discoverTag};  // After LiveLine
+const PidInfo     livePids[6]   = {           // By LiveLine
+//  pid     jump            unit     bytes shift offset  scale    add  width
+  {"010D", "60",           "  mph",  1,    0,    0,     KPH_MPH,  0,   5},   // kph
+  {"010C", "900",          "  rpm",  2,    2,    0,     Q24(1),   0,   5},   // quarter rpm
+  {"0130", "255",          "  wms",  1,    0,    0,     Q24(1),   0,   5},
+  {"0131", "65535",        "  mi",   2,    0,    0,     KPH_MPH,  0,   6},   // km
+  {"0105", "215",          "  F",    1,    0,  -40,     C_F,      32,  7},   // C
+  {"0101", "101010101010", "",       4,    0,    0,     Q24(1),   0,   0}};  // Shown as hex
+int              *liveVar[6]    = {&vehicleSpeed, &vehicleRPM, &warmsSinceRes, &kmSinceRes, &coolantTemp, NULL};
+PidStats<STAT_WINDOW> speedStats("speed"), rpmStats("rpm"), coolantStats("coolant");  // kph, rpm, C
+PidStatsBase     *liveStats[6]  = {&speedStats, &rpmStats, NULL, NULL, &coolantStats, NULL};  // By LiveLine
+TsLog<LOG_PAGES, LOG_PAGE, 3, LOG_NVM_PAGES> tsLog((!jumper||NVM_StoreAllowed), verbose);  // speed kph, rpm, coolant C history
+ObdIo             obd(verbose);               // Serial1 owner, runs on its own thread
 //int led_button = D7;
-extern char       rxIndex       = 0;
+uint8_t           rxIndex       = 0;
 
 
 
@@ -99,307 +146,518 @@ void setup()
   Serial1.begin(9600);
   oled.begin();    // Initialize the OLED
 
-  F = new Queue(MAX_SIZE, GMT, "FAULTS",    (!jumper||NVM_StoreAllowed), verbose);
-	I = new Queue(MAX_SIZE, GMT, "IMPENDING", (!jumper||NVM_StoreAllowed), verbose);
+  nvm.begin();
 	if ( !clearNVM )
 	{
-		impendNVM   = F->loadNVM(faultNVM);
-		int endNVM  = I->loadNVM(impendNVM);
-    if ( endNVM>EEPROM.length() ) // Too much NVM
-    {
-      display(&oled, 0, 0, "NVM OVER", 300000, page, font8x16, ALL);
-    }
+		if ( nvm.kept(faultNVM) )  F.loadNVM(nvm.start(faultNVM));
+		if ( nvm.kept(impendNVM) ) I.loadNVM(nvm.start(impendNVM));
     delay(1500);
 	}
+  if ( nvm.kept(statsNVM) ) stats.loadNVM(nvm.start(statsNVM));
+  if ( nvm.kept(logNVM) )   tsLog.loadNVM(nvm.start(logNVM));
+  F.attach(&stats);
+  I.attach(&stats);
+  F.attach(&frames);      // Only confirmed faults have a stored frame
+  liveScreen    = screens.add("LIVE",   renderLive,   LIVE_DWELL);
+  activeScreen  = screens.add("ACTIVE", renderActive, ACTIVE_DWELL);
+  storedScreen  = screens.add("STORED", renderStored, STORED_DWELL);
+  statusScreen  = screens.add("STATUS", renderStatus, STATUS_DWELL);
+  trendScreen   = screens.add("TREND",  renderTrend,  TREND_DWELL);
+  screens.add("STATS",  renderStats,  STATS_DWELL);
+
+  // Name, function, period, deadline, budget, first release after setup.  Codes are read at once
+  tasks.add("trend",   taskTrend,   TREND_DELAY,    TREND_DELAY,  150UL,  0UL);
+  tasks.add("sample",  taskSample,  SAMPLING_DELAY, 5000UL,       3000UL, SAMPLING_DELAY);
+  tasks.add("read",    taskRead,    READ_DELAY,     10000UL,      6000UL, 0UL);
+  tasks.add("display", taskDisplay, DISPLAY_DELAY,  5000UL,       100UL,  DISPLAY_DELAY);
+  tasks.add("reset",   taskReset,   RESET_DELAY,    30000UL,      3000UL, RESET_DELAY);
+  tasks.add("log",     taskLog,     LOG_DELAY,      LOG_DELAY,    20UL,   SAMPLING_DELAY);
+  tasks.add("freeze",  taskFreeze,  FREEZE_DELAY,   FREEZE_DELAY, 10UL,   0UL);
+
+#ifndef COMPOSITOR
   if ( jumper ) display(&oled, 0, 0, "JUMPER", 3000, page, font5x7, ALL);
   display(&oled, 0, 0, "ACTIVE", 500, page, font5x7, ALL);
 
-  String dispStr;
-  if ( F->printActive(&dispStr)>0 );
+  FixedText<64> dispStr;
+  FixedText<64> line;
+  if ( F.printActive(&dispStr)>0 );
   else dispStr = "----  ";
-  display(&oled, 0, 1, ("F:" + dispStr));
-  if ( I->printActive(&dispStr)>0 );
+  display(&oled, 0, 1, line.add("F:").add(dispStr));
+  if ( I.printActive(&dispStr)>0 );
   else dispStr = "----  ";
-  display(&oled, 0, 3, ("I:" + dispStr), 10000);
+  line.clear();
+  display(&oled, 0, 3, line.add("I:").add(dispStr), 10000);
 
   display(&oled, 0, 0, "STORED IMPEND", 0, page, font5x7, ALL);
-  if ( I->printInActive(&dispStr, 2)>0 );
+  if ( I.printInActive(&dispStr, 2)>0 );
   else dispStr = "----  ";
-  display(&oled, 0, 1, ("I:" + dispStr), 5000);
+  line.clear();
+  display(&oled, 0, 1, line.add("I:").add(dispStr), 5000);
 
   display(&oled, 0, 0, "STORED FAULTS", 0, page, font5x7, ALL);
-  if ( F->printInActive(&dispStr, 2)>0 );
+  if ( F.printInActive(&dispStr, 2)>0 );
   else dispStr = "----  ";
-  display(&oled, 0, 1, ("F:" + dispStr), 10000);
-
+  line.clear();
+  display(&oled, 0, 1, line.add("F:").add(dispStr), 10000);
+#endif
 
   //Reset the OBD-II-UART
   display(&oled, 0, 0, "WAIT", 500, page, font5x7, ALL);
   Serial1.println("ATZ");
   delay(1000);
   getResponse(&oled, rxData);
+  adapterId = rxData;
+  delay(1000);
+  display(&oled, 0, 1, rxData);
+#ifdef OBD_HEADERS
+  rxFlushToChar(&oled, '>');
+  Serial1.println("ATH1");    // CAN ID on each line.  Its prompt is flushed by the first ping
   delay(1000);
-  display(&oled, 0, 1, String(rxData));
+#endif
   Serial.printf("setup ending\n");
   delay(2000);
   WiFi.off();
   delay(1000);
+  busMicros = 0UL;
+  obd.start();    // Serial1 belongs to the I/O thread from here on
+#ifdef OBD_HEADERS
+  if ( !jumper ) obd.submit(obdPing, "0100", NULL, discoverTag, 0UL);  // Who answers, with which PIDs
+#endif
+#ifdef COMPOSITOR
+  screens.show(activeScreen, millis());
+#endif
+  tasks.start(millis());  // First releases count from here, not from boot
 
 //  pinMode(led_button, OUTPUT);
 }
 
 
-void loop(){
-  FaultCode newOne;
-  bool 									displaying;
-  bool 									reading;
-  bool 									resetting;
-  bool                  sampling;
-  unsigned long 				now = millis();     // Keep track of time
-  static unsigned long 	lastDisplay = 0UL;  // Last display time, ms
-  static unsigned long 	lastRead  	= -READ_DELAY;  // Last read time, ms
-  static unsigned long 	lastReset 	= 0UL;  // Last reset time, ms
-  static unsigned long 	lastSample 	= 0UL;  // Last reset time, ms
+// Format one live value into a display line, heap free.  Units come from the registry
+void  formatLive(const uint8_t which, TextBuf *str)
+{
+  str->clear();
+  if ( which==readyLine )
+  {
+    if ( liveOk[which] ) readiness.format(str);
+    else str->add("----------");
+  }
+  else livePids[which].format(*liveVar[which], liveOk[which], str);
+}
 
-  reading 		= ((now-lastRead   ) >= READ_DELAY);
-	if ( reading   ) lastRead = now;
 
-	resetting 	= ((now-lastReset  ) >= RESET_DELAY);
-  if ( resetting  ) lastReset  = now;
+// Show a sampled value.  Compositor redraws the live screen between pings
+// instead of holding the loop on each value.
+void  showSample(const uint8_t which, const bool ok, const uint8_t y, const int hold)
+{
+  liveOk[which] = ok;
+  if ( ok && which==speedLine ) speedGauge.update(vehicleSpeed, trending());
+  if ( ok && which==rpmLine )   rpmTrace.update(vehicleRPM, trending());
+  if ( ok && liveStats[which] ) liveStats[which]->add(*liveVar[which]);
+#ifdef COMPOSITOR
+  (void)y; (void)hold;
+  screens.invalidate(liveScreen);
+  screens.tick(millis());
+#else
+  FixedText<16> str;
+  formatLive(which, &str);
+  display(&oled, 0, y, str, hold);
+#endif
+}
 
-	displaying	= ((now-lastDisplay) >= DISPLAY_DELAY);
-	if ( displaying ) lastDisplay = now;
 
-  sampling	= ((now-lastSample) >= SAMPLING_DELAY);
-	if ( sampling ) lastSample = now;
+// Trend screen on show, so widgets may draw
+bool  trending()
+{
+#ifdef COMPOSITOR
+  return screens.current()==trendScreen;
+#else
+  return false;
+#endif
+}
+
+
+// Speed gauge and RPM trace.  Widgets update themselves incrementally while on show
+void  renderTrend(MicroOLED* oled)
+{
+  (void)oled;   // Widgets hold their own
+  speedGauge.draw();
+  rpmTrace.draw();
+}
 
-  if ( jumper ) display(&oled, 0, 0, "JUMPER", 1000);
 
-  if ( reading )
+// Live PID values, one per line
+void  renderLive(MicroOLED* oled)
+{
+  FixedText<16> str;
+  oled->setFontType(font5x7);
+  for ( uint8_t which=speedLine; which<=readyLine; which++ )
   {
-    unsigned long faultTime = Time.now();
-    // Codes
-    if ( jumper )
-    {
-      getJumpFaultCodes(&oled, "03", "43 01 20 02", faultTime, rxData, &ncodes, codes, \
-        activeCode, ignoring, F);
-      delay(1000);
-      getJumpFaultCodes(&oled, "07", "47 02 20 12 20 13", faultTime, rxData, &ncodes, codes,\
-        activeCode, ignoring, I);
-    }
-    else  // ENGINE
-    {
-      getCodes(&oled, "03", faultTime, rxData, &ncodes, codes, activeCode,  F);
-      getCodes(&oled, "07", faultTime, rxData, &ncodes, codes, pendingCode, I);
-    }
-  }   // reading
+    formatLive(which, &str);
+    oled->setCursor(0, which*oled->getFontHeight());
+    oled->print(str);
+  }
+}
+
 
-  if ( sampling )
+// Window mean and min-max of the live channels with statistics, in display units
+void  renderStats(MicroOLED* oled)
+{
+  FixedText<16> str;
+  oled->setFontType(font5x7);
+  oled->setCursor(0, 0);
+  for ( uint8_t which=speedLine; which<=readyLine; which++ )
   {
-    // Speed
-    if ( jumper )
-    {
-      pingJump(&oled, "010D", "60", rxData);
-      vehicleSpeed = atol(rxData);
-      char tmp[100];
-      sprintf(tmp, "%5.0f  mph", float(vehicleSpeed)*0.6);
-      display(&oled, 0, 1, String(tmp), 1000);
-    }
-    else   // ENGINE
-    {
-      if (ping(&oled, "010D", rxData) == 0)
-      {
-        vehicleSpeed = strtol(&rxData[4], 0, 16);
-        char tmp[100];
-        sprintf(tmp, "%5.0f  mph", float(vehicleSpeed)*0.6);
-        display(&oled, 0, 0, String(tmp), 200);
-      }
-      else
-      {
-        display(&oled, 0, 0, "----  mph", 200);
-      }
-    }
+    PidStatsBase *s = liveStats[which];
+    if ( !s ) continue;
+    const PidInfo &p = livePids[which];
+    const char *unit = p.unit;
+    while ( *unit==' ' ) unit++;
+    str.clear();    // A line at a time, the pair would not fit str
+    if ( s->wCount()==0 ) str.add(unit).add("   ----\n");
+    else                  str.add(unit).addInt(p.display(lroundf(s->wMean())), 10-strlen(unit)).add('\n');
+    oled->print(str);
+    str.clear();
+    if ( s->wCount()==0 ) str.add("    -\n");
+    else                  str.addInt(p.display(s->wMin()), 4).add('-').addInt(p.display(s->wMax()), 5).add('\n');
+    oled->print(str);
+  }
+}
 
-    // RPM  2 bytes  ((A*256)+B)/4
-    if ( jumper )
-    {
-      pingJump(&oled, "010C", "900", rxData);
-      vehicleRPM = atol(rxData);
-      display(&oled, 0, 1, String(vehicleRPM)+"  rpm  ", 1000);
-    }
-    else // ENGINE
-    {
-      if (ping(&oled, "010C", rxData) == 0)
-      {
-        vehicleRPM = strtol(&rxData[4], 0, 16)/4;
-        display(&oled, 0, 0, (String(vehicleRPM)+"  rpm"), 200);
-      }
-      else
-      {
-        display(&oled, 0, 0, "----  rpm", 200);
-      }
-    }
 
+// Print live channel statistics, engine units
+void  printStats()
+{
+  for ( uint8_t which=speedLine; which<=readyLine; which++ )
+    if ( liveStats[which] ) liveStats[which]->Print();
+}
 
-    // Warmups Since Reset 1 byte
-    if ( jumper )
-    {
-      pingJump(&oled, "0130", "255", rxData);
-      warmsSinceRes = atol(rxData);
-      display(&oled, 0, 1, String(warmsSinceRes)+"   wms   ", 1000);
-    }
-    else // ENGINE
-    {
-      if (ping(&oled, "0130", rxData) == 0)
-      {
-        warmsSinceRes = strtol(&rxData[4], 0, 16); // number
-        display(&oled, 0, 0, (String(warmsSinceRes)+"   wms   "), 500);
-      }
-      else
-      {
-        display(&oled, 0, 0, "---- wms   ", 200);
-      }
-    }
 
-    // km Since Reset 2 byte
-    if ( jumper )
-    {
-      pingJump(&oled, "0131", "65535", rxData);
-      kmSinceRes = atol(rxData);
-      char tmp[100];
-      sprintf(tmp, "%6.0f  mi", float(kmSinceRes)*0.6);
-      display(&oled, 0, 1, String(tmp), 1000);
-    }
-    else // ENGINE
-    {
-      if (ping(&oled, "0131", rxData) == 0)
-      {
-        kmSinceRes = strtol(&rxData[4], 0, 16); // km
-        char tmp[100];
-        sprintf(tmp, "%6.0f  mi", float(kmSinceRes)*0.6);
-        display(&oled, 0, 0, String(tmp), 500);
-      }
-      else
-      {
-        display(&oled, 0, 0, "----    mi", 200);
-      }
-    }
+// Unreset fault and impending codes
+void  renderActive(MicroOLED* oled)
+{
+  FixedText<64> dispStr;
+  oled->setFontType(font5x7);
+  oled->setCursor(0, 0);
+  oled->print("ACTIVE\n");
+  F.printActive(&dispStr);
+  oled->print("F:");
+  oled->print(dispStr);
+  oled->print("\n");
+  I.printActive(&dispStr);
+  oled->print("I:");
+  oled->print(dispStr);
+}
 
-    // Coolant temp 1 byte  0105
-    if ( jumper )
-    {
-      pingJump(&oled, "0105", "215", rxData);
-      coolantTemp = atoi(rxData);
-      char tmp[100];
-      sprintf(tmp, "%7.0f  F", float(coolantTemp)*9/5+32);
-      display(&oled, 0, 1, String(tmp), 1000);
-    }
-    else // ENGINE
-    {
-      if (ping(&oled, "0105", rxData) == 0)
-      {
-        coolantTemp = strtol(&rxData[4], 0, 16)-40;  // C
-        char tmp[100];
-        sprintf(tmp, "%7.0f  F", float(coolantTemp)*9/5+32);
-        display(&oled, 0, 0, String(tmp), 200);
-      }
-      else
+
+// Most recent reset fault and impending codes
+void  renderStored(MicroOLED* oled)
+{
+  FixedText<32> dispStr;
+  oled->setFontType(font5x7);
+  oled->setCursor(0, 0);
+  oled->print("STORED\n");
+  if ( F.printInActive(&dispStr, 1)==0 ) dispStr = "----\n";
+  oled->print("F:");
+  oled->print(dispStr);
+  if ( I.printInActive(&dispStr, 1)==0 ) dispStr = "----\n";
+  oled->print("I:");
+  oled->print(dispStr);
+}
+
+
+// Adapter, bus and NVM health
+void  renderStatus(MicroOLED* oled)
+{
+  FixedText<16> str;
+  oled->setFontType(font5x7);
+  oled->setCursor(0, 0);
+  oled->print("STATUS\n");
+  oled->print(adapterId);
+  oled->print("\n");
+  str.add("bus").addFixed(busUtil, 1, 5).add("%\n");
+  oled->print(str);
+  if ( readiness.valid() ) oled->print(readiness.ready() ? "insp ready\n" : "not ready\n");
+  if ( jumper )  oled->print("JUMPER\n");
+}
+
+
+// Request confirmed and pending codes.  takeReply logs them
+void  taskRead(unsigned long now)
+{
+  (void)now;
+  unsigned long faultTime = Time.now();
+  if ( jumper )
+  {
+    obd.submit(obdJump, "03", "43 01 20 02",       confirmedTag, faultTime);
+    obd.submit(obdJump, "07", "47 02 20 12 20 13", pendingTag,   faultTime);
+  }
+  else  // ENGINE
+  {
+    obd.submit(obdPing, "03", NULL, confirmedTag, faultTime);
+    obd.submit(obdPing, "07", NULL, pendingTag,   faultTime);
+  }
+}
+
+
+// Request live data.  takeReply shows each value as it arrives
+void  taskSample(unsigned long now)
+{
+  (void)now;
+  for ( uint8_t which=speedLine; which<=readyLine; which++ )
+  {
+    if ( jumper ) obd.submit(obdJump, livePids[which].pid, livePids[which].jump, which, 0UL);
+    else if ( ecus.supported(strtol(livePids[which].pid+2, NULL, 16)) )   // No ECU has it, skip
+                  obd.submit(obdPing, livePids[which].pid, NULL,                  which, 0UL);
+  }
+}
+
+
+// Log jumper codes unless ignoring
+void  takeJumpCodes(ObdReply *r, QueueBase *Q)
+{
+  int nActive = parseCodes(r->line.span(), codes, &ncodes);
+  for ( int i=0; (i<nActive&&!ignoring); i++ ) Q->newCode(r->time, codes[i]);
+  if ( verbose>2 ) Q->Print();
+}
+
+
+// Use one reply from the OBD I/O thread
+void  takeReply(ObdReply *r)
+{
+  const char *rx  = r->rx;                    // Jumper replies are plain decimal
+  ByteSpan    A   = r->line.span().from(2);   // Engine data bytes A, B, ... after mode and PID
+  bool ok         = jumper || r->status==0;
+  uint8_t y       = jumper ? 1 : 0;
+  if ( !ok && verbose>1 ) Serial.printf("No conn> %s\n", r->cmd);
+  ecus.take(r->ecu, r->ecus, r->tag==confirmedTag||r->tag==pendingTag ? r->time : 0UL);
+  switch ( r->tag )
+  {
+    case speedLine:
+      if ( ok ) vehicleSpeed = jumper ? atol(rx) : livePids[speedLine].decode(A);
+      showSample(speedLine, ok, y, jumper ? 1000 : 200);
+      break;
+    case rpmLine:   // RPM  2 bytes  ((A*256)+B)/4
+      if ( ok ) vehicleRPM = jumper ? atol(rx) : livePids[rpmLine].decode(A);
+      showSample(rpmLine, ok, y, jumper ? 1000 : 200);
+      break;
+    case warmsLine: // Warmups Since Reset 1 byte
+      if ( ok )
       {
-        display(&oled, 0, 0, "------- F", 200);
+        warmsSinceRes = jumper ? atol(rx) : livePids[warmsLine].decode(A);
+        stats.warmups(warmsSinceRes);
       }
-    }
-
-    // Ready bytes  4 bytes
-    if ( jumper )
-    {
-      pingJump(&oled, "0101", "101010101010", rxData);
-      display(&oled, 0, 1, String(rxData), 1000);
-    }
-    else // ENGINE
+      showSample(warmsLine, ok, y, jumper ? 1000 : (ok ? 500 : 200));
+      break;
+    case kmLine:    // km Since Reset 2 byte
+      if ( ok ) kmSinceRes = jumper ? atol(rx) : livePids[kmLine].decode(A);
+      showSample(kmLine, ok, y, jumper ? 1000 : (ok ? 500 : 200));
+      break;
+    case coolantLine:  // Coolant temp 1 byte  0105
+      if ( ok ) coolantTemp = jumper ? atoi(rx) : livePids[coolantLine].decode(A);  // C
+      showSample(coolantLine, ok, y, jumper ? 1000 : 200);
+      break;
+    case readyLine: // Ready bytes  4 bytes.  A short reply is a failed sample
+      ok = ok && A.len>=4;
+      if ( ok ) readiness.update(A);
+      showSample(readyLine, ok, y, jumper ? 1000 : 1500);
+      break;
+    case confirmedTag:
+      if ( jumper )  takeJumpCodes(r, &F);
+      else if ( ok ) takeCodes(r->time, r->line.span(), &ncodes, codes, activeCode, &F);
+      break;
+    case pendingTag:
+      if ( jumper )  takeJumpCodes(r, &I);
+      else if ( ok ) takeCodes(r->time, r->line.span(), &ncodes, codes, pendingCode, &I);
+      break;
+    case freezeTag:
+      frames.take(r->cmd, r->status==0, r->line.span());
+      break;
+    case discoverTag:   // Support ranges chain through PID 20, 40, ... above the one just asked
     {
-      if (ping(&oled, "0101", rxData) == 0)
+      uint8_t next = ecus.nextRange(strtol(r->cmd+2, NULL, 16));
+      if ( next>0 )
       {
-        String str = "1-" + String(&rxData[4]);
-        char tmp[100];
-        sprintf(tmp, "%10s", str.c_str());
-        display(&oled, 0, 0, tmp, 1500);
+        char cmd[8];
+        sprintf(cmd, "01%02X", next);
+        obd.submit(obdPing, cmd, NULL, discoverTag, 0UL);
       }
-      else
+      else if ( verbose>1 ) ecus.Print();
+      break;
+    }
+    case trendTag:
+      if ( ok )
       {
-        display(&oled, 0, 0, "-------------", 1500);
+        vehicleRPM = livePids[rpmLine].decode(A);
+        rpmTrace.update(vehicleRPM, trending());
+        if ( verbose>4 ) Serial.printf("rpm trace update %lu us\n", rpmTrace.lastMicros());
       }
-    }
-
+      break;
+  }
+}
 
 
-  }  // sampling
+// Bus utilization and fault lists
+void  taskDisplay(unsigned long now)
+{
+  static unsigned long 	lastUtil 	  = 0UL;  // Last bus utilization report, ms
+  unsigned long bus = busMicros.exchange(0UL);  // Read and cleared at once, the I/O thread may be adding
+  busUtil   = (now-lastUtil)>0 ? bus/(now-lastUtil) : 0;
+  lastUtil  = now;
+  if ( verbose>2 ) tasks.Print();
+  if ( verbose>2 && obd.logLost()>0 ) Serial.printf("I/O log lost %lu bytes\n", obd.logLost());
+  if ( verbose>3 ) printStats();
+  if ( verbose>3 ) tsLog.Print();
+#ifdef COMPOSITOR
+  if ( verbose>2 ) Serial.printf("bus utilization %d.%d%% with compositor, free mem %lu\n", busUtil/10, busUtil%10, System.freeMemory());
+  if ( verbose>3 ) Serial.printf("widget update:  gauge %lu us, trace %lu us\n", speedGauge.lastMicros(), rpmTrace.lastMicros());
+  screens.invalidate(activeScreen);
+  screens.invalidate(storedScreen);
+  screens.invalidate(statusScreen);
+#else
+  if ( verbose>2 ) Serial.printf("bus utilization %d.%d%% with blocking holds, free mem %lu\n", busUtil/10, busUtil%10, System.freeMemory());
+  uint8_t line;
+  if ( jumper ) line = 2; else line = 1;
+  FixedText<64> dispStr;
+  FixedText<64> str;
+		F.printActive(&dispStr);
+  display(&oled, 0, line, str.add("F:").add(dispStr));
+		I.printActive(&dispStr);
+  str.clear();
+  display(&oled, 0, line+1, str.add("I:").add(dispStr));
+#endif
+}
 
 
-  if ( displaying )
-	{
-    uint8_t line;
-    if ( jumper ) line = 2; else line = 1;
-    String dispStr;
-		F->printActive(&dispStr);
-    display(&oled, 0, line, ("F:" + dispStr));
-		I->printActive(&dispStr);
-    display(&oled, 0, line+1, ("I:" + dispStr));
-	} // displaying
-
-  if ( resetting )
-	{
-    Serial.printf("RESETTING...\n");
-    int finalNVM;
+// Store NVM and reset faults
+void  taskReset(unsigned long now)
+{
+  (void)now;
+  Serial.printf("RESETTING...\n");
+  int faultEnd, impendEnd;
+  if ( clearNVM )
+  {
+    faultEnd  = F.clearNVM(nvm.start(faultNVM));
+    impendEnd = I.clearNVM(nvm.start(impendNVM));
+  }
+	  else
+  {
+    faultEnd  = F.storeNVM(nvm.start(faultNVM));
+    impendEnd = I.storeNVM(nvm.start(impendNVM));
+  }
+  if ( faultEnd<0 || impendEnd<0 )
     if ( clearNVM )
+      Serial.printf("Failed pre-reset clear NVM\n");
+    else
+      Serial.printf("Failed pre-reset storeNVM\n");
+  else
+	  {
+    Serial.printf("Success clear/store NVM\n");
+    if ( jumper )
     {
-      impendNVM = F->clearNVM(faultNVM);
-      finalNVM  = I->clearNVM(impendNVM);
-      if ( finalNVM>EEPROM.length() ) // Too much NVM
-      {
-        display(&oled, 0, 0, "NVM OVER", 300000, page, font8x16, ALL);
-      }
+      F.resetAll();
+      ecus.resetCodes();
     }
-	  else
+    else // ENGINE
     {
-      impendNVM = F->storeNVM(faultNVM);
-      finalNVM  = I->storeNVM(impendNVM);
-      if ( finalNVM>EEPROM.length() ) // Too much NVM
-      {
-        display(&oled, 0, 0, "NVM OVER", 300000, page, font8x16, ALL);
-      }
-    }
-    if ( impendNVM<0 || finalNVM<0 )
-      if ( clearNVM )
-        Serial.printf("Failed pre-reset clear NVM\n");
-      else
-        Serial.printf("Failed pre-reset storeNVM\n");
-    else
-	  {
-      Serial.printf("Success clear/store NVM\n");
-      if ( jumper )
-      {
-        F->resetAll();
-      }
-      else // ENGINE
-      {
-//        if (F->numActive()>0 || I->numActive()>0)
+//        if (F.numActive()>0 || I.numActive()>0)
 //              digitalWrite(led_button, HIGH);
 //        else
 //              digitalWrite(led_button, LOW);
-        if ( F->numActive()>0 || (I->numActive()>0 && warmsSinceRes>1))
-        {
-          pingReset(&oled, "04");
-          F->resetAll();
-          I->resetAll();
-        }
+      if ( F.numActive()>0 || (I.numActive()>0 && warmsSinceRes>1))
+      {
+        obd.submit(obdReset, "04", NULL, resetTag, 0UL);
+        F.resetAll();
+        I.resetAll();
+        ecus.resetCodes();
       }
+    }
 	  }
-    if ( !clearNVM )
+  if ( !clearNVM )
+  {
+    F.storeNVM(nvm.start(faultNVM));
+    I.storeNVM(nvm.start(impendNVM));
+    Serial.printf("Post-reset store NVM\n");
+  }
+  stats.storeNVM(nvm.start(statsNVM));
+  tsLog.storeNVM(nvm.start(logNVM));
+  if ( verbose>2 ) stats.Print();
+  unsigned long nvmBytes = F.nvmBytes() + I.nvmBytes();
+  if ( verbose>1 ) Serial.printf("NVM written %lu bytes in %lu puts since boot, %lu bytes per day\n", nvmBytes,\
+    F.nvmWrites()+I.nvmWrites(), (unsigned long)((uint64_t)nvmBytes*86400000ULL/millis()));
+}
+
+
+// Readiness event:  a monitor changed state, or the MIL or DTC count did
+void  readyChange(const uint8_t mon, const bool supported, const bool complete)
+{
+  if ( verbose>1 )
+  {
+    if ( mon==MON_MIL ) Serial.printf("readiness:  MIL %s, %d DTCs\n", readiness.mil() ? "on" : "off", readiness.dtcs());
+    else Serial.printf("readiness:  %s %s\n", readiness.name(mon), !supported ? "not supported" : (complete ? "complete" : "incomplete"));
+  }
+  screens.invalidate(statusScreen);
+}
+
+
+// Capture a pending freeze frame once the bus is idle.  takeReply fills it in
+void  taskFreeze(unsigned long now)
+{
+  (void)now;
+  if ( jumper || obd.pending()>0 ) return;
+  int n = frames.begin();
+  for ( int i=0; i<n; i++ )
+  {
+    const char *cmd = FreezeFramesBase::cmd(i);
+    if ( !obd.submit(obdPing, cmd, NULL, freezeTag, 0UL) ) frames.take(cmd, false, ByteSpan(NULL, 0));
+  }
+}
+
+
+// Log a row of live values once the engine has answered
+void  taskLog(unsigned long now)
+{
+  (void)now;
+  if ( !liveOk[speedLine] && !liveOk[rpmLine] && !liveOk[coolantLine] ) return;
+  long values[3] = {vehicleSpeed, vehicleRPM, coolantTemp};
+  tsLog.add(Time.now(), values);
+}
+
+
+// High rate RPM trace while on show.  Only the changed columns are redrawn
+void  taskTrend(unsigned long now)
+{
+  (void)now;
+  if ( !trending() || jumper || obd.pending()>0 ) return;  // Skip rather than queue behind slow requests
+  obd.submit(obdPing, "010C", NULL, trendTag, 0UL);
+}
+
+
+void loop(){
+  unsigned long now = millis();     // Keep track of time
+
+#ifdef COMPOSITOR
+  screens.tick(now);
+#else
+  if ( jumper ) display(&oled, 0, 0, "JUMPER", 1000);
+#endif
+
+#ifndef OBD_THREAD
+  obd.service();
+#endif
+  ObdReply reply;
+  while ( obd.poll(&reply) ) takeReply(&reply);
+  obd.drainLog(&Serial);            // What the I/O thread logged
+  if ( Serial.available()>0 )   // Console query.  Anything else, e.g. a line end, is consumed and ignored
+  {
+    char c = Serial.read();
+    switch ( c )
     {
-      impendNVM = F->storeNVM(faultNVM);
-      finalNVM  = I->storeNVM(impendNVM);
-      Serial.printf("Post-reset store NVM\n");
+      case 's': printStats(); break;
+      case 'l': tsLog.dump("speed,rpm,coolant"); tsLog.Print(); break;
+      case 'f': frames.Print(); break;
+      case 'e': ecus.Print(); break;
     }
-	}
+  }
 
+  tasks.dispatch(now);
 }
@@ -0,0 +1,139 @@
+#include "application.h"
+#ifdef OBDIO_HOST
+#include <thread>   // Ahead of SparkFunMicroOLED.h, whose swap macro breaks it
+#endif
+#include "myQueue.h"
+#include "mySubs.h"
+#include "myObdIo.h"
+
+// class ObdIo
+// constructors
+ObdIo::ObdIo(const int verbose)
+: running_(false), busy_(false), dropped_(0UL), verbose_(verbose)
+{}
+
+// functions
+// UI side:  print what the I/O thread logged.  Returns bytes
+int ObdIo::drainLog(Print *out)
+{
+	return log_.drain(out);
+}
+
+// Returns requests refused because the queue was full
+unsigned long ObdIo::dropped()
+{
+	return dropped_;
+}
+
+// Returns I/O thread log bytes dropped because the UI fell behind
+unsigned long ObdIo::logLost()
+{
+	return log_.lost();
+}
+
+// Requests not yet answered, counting the one on the bus
+int ObdIo::pending()
+{
+	return requests_.size() + (busy_ ? 1 : 0);
+}
+
+// UI side:  next reply.  False if none
+bool ObdIo::poll(ObdReply *r)
+{
+	return replies_.pop(r);
+}
+
+// I/O side:  run one request and queue its reply.  False if none waiting.
+// A full reply queue holds the request until the UI catches up
+bool ObdIo::service()
+{
+	if ( replies_.size()>=OBD_QUEUE ) return false;
+	ObdRequest q;
+	busy_ = true;     // Before the pop, so pending() never reads 0 in between
+	if ( !requests_.pop(&q) )
+	{
+		busy_ = false;
+		return false;
+	}
+	reply_.rx[0] 		= '\0';
+	reply_.line 		= ObdLine();
+	reply_.ecus 		= 0;
+	strncpy(reply_.cmd, q.cmd, sizeof(reply_.cmd));
+	reply_.tag 	= q.tag;
+	reply_.time = q.time;
+	switch ( q.kind )
+	{
+#ifdef OBD_HEADERS
+		case obdPing:
+			reply_.status = ping(NULL, q.cmd, reply_.rx, &reply_.line, &demux_);
+			reply_.ecus 	= demux_.copy(reply_.ecu, MAX_ECUS);
+			break;
+#else
+		case obdPing: 	reply_.status = ping(NULL, q.cmd, reply_.rx, &reply_.line); 				break;
+#endif
+		case obdJump: 	reply_.status = pingJump(NULL, q.cmd, q.val, reply_.rx, &reply_.line); 	break;
+		case obdReset: 	pingReset(NULL, q.cmd); reply_.status = 0; 												break;
+	}
+	reply_.rx[OBD_RX-1] = '\0';
+	replies_.push(reply_);
+	busy_ = false;
+	return true;
+}
+
+// Start the I/O thread.  Without OBD_THREAD the caller runs service() instead
+void ObdIo::start()
+{
+#ifdef OBD_THREAD
+	if ( running_ ) return;
+	running_ = true;
+	ioLog = &log_;    // Serial is the UI's from here on
+#ifdef OBDIO_HOST
+	std::thread(worker, this).detach();
+#else
+	new Thread("obd", worker, this, OS_THREAD_PRIORITY_DEFAULT, OBD_STACK);
+#endif
+#endif
+}
+
+// Ask the I/O thread to finish after its current request
+void ObdIo::stop()
+{
+	running_ = false;
+}
+
+// UI side:  queue a request.  False if the queue is full
+bool ObdIo::submit(const ObdKind kind, const char *cmd, const char *val, const uint8_t tag, const unsigned long time)
+{
+	ObdRequest q;
+	strncpy(q.cmd, cmd, sizeof(q.cmd)-1);
+	q.cmd[sizeof(q.cmd)-1] = '\0';
+	if ( val )
+	{
+		strncpy(q.val, val, sizeof(q.val)-1);
+		q.val[sizeof(q.val)-1] = '\0';
+	}
+	q.kind 	= kind;
+	q.tag 	= tag;
+	q.time 	= time;
+	if ( requests_.push(q) ) return true;
+	dropped_++;
+	if ( verbose_>2 ) Serial.printf("ObdIo:  request %s dropped, queue full\n", cmd);
+	return false;
+}
+
+// Thread body
+void ObdIo::worker(void *arg)
+{
+	ObdIo *io = (ObdIo *)arg;
+	while ( io->running_ )
+	{
+		if ( !io->service() )
+		{
+#ifdef OBDIO_HOST
+			std::this_thread::yield();
+#else
+			delay(1);
+#endif
+		}
+	}
+}
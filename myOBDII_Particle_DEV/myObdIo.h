@@ -0,0 +1,169 @@
+#ifndef _myObdIo_h
+#define _myObdIo_h
+
+#include <stdint.h>
+#include <atomic>
+#include "myResponse.h"
+#include "myEcu.h"
+
+// Usually defined.  Comment out to run OBD requests from loop() through
+// ObdIo::service() instead of a thread, e.g. to compare timing.
+#define OBD_THREAD
+
+#define OBD_RX 			104   // Reply text, getResponse stops at 100
+#define OBD_QUEUE 	16    // Requests or replies in flight, power of 2.  A sample batch and a freeze frame batch together
+#define OBD_LOG 		1024  // I/O thread log text waiting for the UI, bytes, power of 2
+// I/O thread stack, bytes.  The deepest call is worker, service with an
+// ObdRequest, ping with an ObdLine, then CanDemux::frame with another ObdLine
+// and tokenize/hexDecode, about 300 bytes of locals.  ioLog->printf on the same
+// path formats with newlib's vsnprintf, up to about 1.5 KB more.  Code parsing
+// and its codes[100] run in takeReply on the UI side, not here.  The Particle
+// default of 3 KB is too close;  4 KB leaves room for interrupt frames
+#define OBD_STACK 	4096
+
+// Single producer, single consumer ring.  Lock free:  the producer only moves
+// tail_ and the consumer only moves head_, each published with release order.
+template <typename T, int N>
+class SpscQueue
+{
+private:
+	T 										buf_[N];
+	std::atomic<uint16_t> head_;    // Next to pop
+	std::atomic<uint16_t> tail_;    // Next to push
+public:
+	SpscQueue(void) : head_(0), tail_(0)
+	{
+		static_assert(N>1 && N<=32768 && (N&(N-1))==0, "SpscQueue size must be a power of 2");
+	}
+	// Producer side.  False if full
+	bool push(const T &x)
+	{
+		uint16_t t = tail_.load(std::memory_order_relaxed);
+		if ( (uint16_t)(t-head_.load(std::memory_order_acquire))==N ) return false;
+		buf_[t&(N-1)] = x;
+		tail_.store(t+1, std::memory_order_release);
+		return true;
+	}
+	// Consumer side.  False if empty
+	bool pop(T *x)
+	{
+		uint16_t h = head_.load(std::memory_order_relaxed);
+		if ( h==tail_.load(std::memory_order_acquire) ) return false;
+		*x = buf_[h&(N-1)];
+		head_.store(h+1, std::memory_order_release);
+		return true;
+	}
+	int size(void) const
+	{
+		return (uint16_t)(tail_.load(std::memory_order_acquire)-head_.load(std::memory_order_acquire));
+	}
+};
+
+// Text written on the I/O thread for the UI to print.  Serial is not safe to
+// share between threads, so the I/O side logs here and loop() drains it to
+// Serial.  Text that finds the pipe full is dropped and counted.
+class LogPipe : public Print
+{
+private:
+	SpscQueue<char, OBD_LOG> 					buf_;
+	std::atomic<unsigned long> 	lost_;
+public:
+	LogPipe(void) : lost_(0UL) {}
+	// Producer side
+	virtual size_t write(uint8_t c)
+	{
+		if ( buf_.push((char)c) ) return 1;
+		lost_++;
+		return 0;
+	}
+	using Print::write;
+	// Consumer side.  Copy waiting text to out, returns bytes
+	int drain(Print *out)
+	{
+		char c;
+		int n = 0;
+		while ( buf_.pop(&c) ) { out->write((uint8_t)c); n++; }
+		return n;
+	}
+	unsigned long lost(void) const { return lost_.load(); }
+};
+
+// What to do with a request
+enum ObdKind : uint8_t {obdPing, obdJump, obdReset};
+
+// UI to I/O:  one adapter command.  tag and time come back with the reply
+class ObdRequest
+{
+public:
+	char 					cmd[8];
+	char 					val[24];      // Jumper reply to simulate
+	ObdKind 			kind;
+	uint8_t 			tag;
+	unsigned long time;
+	ObdRequest(void)
+	{
+		cmd[0] 	= '\0';
+		val[0] 	= '\0';
+		kind 		= obdPing;
+		tag 		= 0;
+		time 		= 0UL;
+	}
+	~ObdRequest(){}
+};
+
+// I/O to UI:  result of one request
+class ObdReply
+{
+public:
+	char 					rx[OBD_RX];
+	ObdLine 			line;         // rx classified and decoded once, by the I/O side.  Lowest ECU under OBD_HEADERS
+	EcuLine 			ecu[MAX_ECUS];  // Every ECU that answered, OBD_HEADERS
+	uint8_t 			ecus;
+	char 					cmd[8];
+	uint8_t 			tag;
+	int8_t 				status;       // 0 ok, else not connected or NO DATA
+	unsigned long time;
+	ObdReply(void)
+	{
+		rx[0] 	= '\0';
+		cmd[0] 	= '\0';
+		tag 		= 0;
+		status 	= 0;
+		time 		= 0UL;
+		ecus 		= 0;
+	}
+	~ObdReply(){}
+};
+
+// Owner of Serial1.  Requests are queued by the UI side and run in order on a
+// dedicated thread, a Particle Thread on the Photon or std::thread on the host
+// (OBDIO_HOST).  Replies are queued back and collected with poll().  Only the
+// I/O side touches the UART, so the UI never blocks on the bus.  Once started,
+// the I/O side logs through ioLog into a LogPipe that the UI drains.
+class ObdIo
+{
+private:
+	SpscQueue<ObdRequest, OBD_QUEUE> 	requests_;
+	SpscQueue<ObdReply, OBD_QUEUE> 		replies_;
+	ObdReply 						reply_;       // Being filled, I/O side
+	CanDemux 						demux_;       // Frames of reply_ by ECU, OBD_HEADERS
+	LogPipe 						log_;         // I/O thread text, printed by the UI
+	std::atomic<bool> 	running_;
+	std::atomic<bool> 	busy_;        // A request popped and not yet answered
+	unsigned long 			dropped_;     // Requests refused, queue full
+	int 								verbose_;
+	static void worker(void *arg);
+public:
+	ObdIo(const int verbose);
+	int  drainLog(Print *out);
+	unsigned long dropped(void);
+	unsigned long logLost(void);
+	int  pending(void);
+	bool poll(ObdReply *r);
+	bool service(void);
+	void start(void);
+	void stop(void);
+	bool submit(const ObdKind kind, const char *cmd, const char *val, const uint8_t tag, const unsigned long time);
+};
+
+#endif
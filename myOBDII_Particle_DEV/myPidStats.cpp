@@ -0,0 +1,178 @@
+#include "application.h"
+#include "myPidStats.h"
+#include "math.h"
+
+// Print x to one decimal without float printf
+static void printTenths(const float x)
+{
+	long t = lroundf(x*10.0f);
+	if ( t<0 ) { Serial.print('-'); t = -t; }
+	Serial.printf("%ld.%ld", t/10, t%10);
+}
+
+// class PidStatsBase
+// constructors
+PidStatsBase::PidStatsBase(const char *name, long *ring, uint8_t *lows, uint8_t *highs, const uint8_t size)
+: name_(name), ring_(ring), lows_(lows), highs_(highs), size_(size)
+{
+	reset();
+}
+
+// functions
+// New sample
+void PidStatsBase::add(const long v)
+{
+	// All time
+	n_++;
+	if ( n_==1 ) ref_ = v;
+	long d = v - ref_;
+	total_ 		+= d;
+	totalSq_ 	+= (int64_t)d*d;
+	if ( n_==1 || v<min_ ) min_ = v;
+	if ( n_==1 || v>max_ ) max_ = v;
+
+	// Window.  Slot pos_ holds the oldest sample once full:  retire it first
+	if ( wn_==size_ )
+	{
+		long old = ring_[pos_];
+		sum_ 		-= old;
+		sumSq_ 	-= (int64_t)old*old;
+		if ( lowN_>0 && lows_[lowH_]==pos_ )
+		{
+			lowH_ = lowH_+1==size_ ? 0 : lowH_+1;
+			lowN_--;
+		}
+		if ( highN_>0 && highs_[highH_]==pos_ )
+		{
+			highH_ = highH_+1==size_ ? 0 : highH_+1;
+			highN_--;
+		}
+	}
+	else wn_++;
+	ring_[pos_] = v;
+	sum_ 		+= v;
+	sumSq_ 	+= (int64_t)v*v;
+	push(lows_,  &lowH_,  &lowN_,  true,  v);
+	push(highs_, &highH_, &highN_, false, v);
+	pos_ = pos_+1==size_ ? 0 : pos_+1;
+}
+
+// Returns samples since reset
+unsigned long PidStatsBase::count()
+{
+	return n_;
+}
+
+// Returns largest sample since reset
+long PidStatsBase::max()
+{
+	return max_;
+}
+
+// Returns mean since reset
+float PidStatsBase::mean()
+{
+	return n_>0 ? ref_ + (float)total_/n_ : 0.0f;
+}
+
+// Returns smallest sample since reset
+long PidStatsBase::min()
+{
+	return min_;
+}
+
+// Returns channel name
+const char *PidStatsBase::name()
+{
+	return name_;
+}
+
+// Print all time and window summaries on one line
+void PidStatsBase::Print()
+{
+	Serial.printf("%-8s n %6lu mean ", name_, n_);
+	printTenths(mean());
+	Serial.printf(" sd ");
+	printTenths(stddev());
+	Serial.printf(" min %ld max %ld | last %u mean ", min_, max_, wn_);
+	printTenths(wMean());
+	Serial.printf(" sd ");
+	printTenths(wStddev());
+	Serial.printf(" min %ld max %ld\n", wMin(), wMax());
+}
+
+// Append slot pos_ holding v to a monotonic queue, first dropping the slots it
+// dominates.  low keeps rising values so the front is the minimum
+void PidStatsBase::push(uint8_t *q, uint8_t *head, uint8_t *len, const bool low, const long v)
+{
+	while ( *len>0 )
+	{
+		uint8_t back = *head + *len - 1;
+		if ( back>=size_ ) back -= size_;
+		long b = ring_[q[back]];
+		if ( low ? b<v : b>v ) break;
+		(*len)--;
+	}
+	uint8_t at = *head + *len;
+	if ( at>=size_ ) at -= size_;
+	q[at] = pos_;
+	(*len)++;
+}
+
+// Forget everything
+void PidStatsBase::reset()
+{
+	n_ 		= 0UL;
+	ref_ 	= 0L;
+	total_ 	= 0;
+	totalSq_ = 0;
+	min_ 	= 0L;
+	max_ 	= 0L;
+	pos_ 	= 0;
+	wn_ 	= 0;
+	lowH_ = 0; lowN_ 	= 0;
+	highH_ = 0; highN_ = 0;
+	sum_ 	= 0;
+	sumSq_ = 0;
+}
+
+// Returns sample standard deviation since reset
+float PidStatsBase::stddev()
+{
+	if ( n_<2 ) return 0.0f;
+	float t 	= (float)total_;
+	float ss 	= (float)totalSq_ - t*t/n_;
+	return ss>0.0f ? sqrtf(ss/(n_-1)) : 0.0f;
+}
+
+// Returns samples in window
+uint8_t PidStatsBase::wCount()
+{
+	return wn_;
+}
+
+// Returns largest sample in window
+long PidStatsBase::wMax()
+{
+	return highN_>0 ? ring_[highs_[highH_]] : 0L;
+}
+
+// Returns mean of window
+float PidStatsBase::wMean()
+{
+	return wn_>0 ? (float)sum_/wn_ : 0.0f;
+}
+
+// Returns smallest sample in window
+long PidStatsBase::wMin()
+{
+	return lowN_>0 ? ring_[lows_[lowH_]] : 0L;
+}
+
+// Returns sample standard deviation of window, from exact sums
+float PidStatsBase::wStddev()
+{
+	if ( wn_<2 ) return 0.0f;
+	int64_t ss = (int64_t)wn_*sumSq_ - sum_*sum_;
+	return sqrtf((float)ss/((float)wn_*(wn_-1)));
+}
@@ -0,0 +1,68 @@
+#ifndef _myPidStats_h
+#define _myPidStats_h
+
+#include <stdint.h>
+
+#define STAT_WINDOW 	32    // Samples in the sliding window
+
+// Running statistics of one sampled channel in fixed memory, constant time per
+// sample.  Storage belongs to the derived PidStats<W>.
+//   All time:  integer sums of each sample's offset from the first, min and
+//              max.  The offset keeps the sums small, so the accessors' float
+//              mean and variance lose little to cancellation.
+//   Window:    the last W samples kept in a ring.  Exact integer sums, so the
+//              sample leaving the window is subtracted without drift, and
+//              monotonic queues of ring slots for min and max, amortized O(1).
+// add() is integer only;  float appears only in the mean and sd accessors.
+class PidStatsBase
+{
+protected:
+	const char 		*name_;
+	unsigned long n_;
+	long 					ref_;         // First sample, the all time sums are offsets from it
+	int64_t 			total_, totalSq_;
+	long 					min_, max_;
+	long 					*ring_;       // Window samples
+	uint8_t 			*lows_;       // Ring slots with rising values, front is window min
+	uint8_t 			*highs_;      // Ring slots with falling values, front is window max
+	uint8_t 			size_;        // W
+	uint8_t 			pos_;         // Next ring slot, oldest once full
+	uint8_t 			wn_;          // Samples in window
+	uint8_t 			lowH_, lowN_, highH_, highN_;   // Queue head slot and length
+	int64_t 			sum_, sumSq_; // Over window
+	PidStatsBase(const char *name, long *ring, uint8_t *lows, uint8_t *highs, const uint8_t size);
+	void push(uint8_t *q, uint8_t *head, uint8_t *len, const bool low, const long v);
+public:
+	void add(const long v);
+	unsigned long count(void);
+	long max(void);
+	float mean(void);
+	long min(void);
+	const char *name(void);
+	void Print(void);
+	void reset(void);
+	float stddev(void);
+	uint8_t wCount(void);
+	long wMax(void);
+	float wMean(void);
+	long wMin(void);
+	float wStddev(void);
+};
+
+// Channel with a W sample window of inline storage
+template <uint8_t W>
+class PidStats : public PidStatsBase
+{
+private:
+	long 		store_[W];
+	uint8_t lowSlots_[W];
+	uint8_t highSlots_[W];
+public:
+	PidStats(const char *name)
+	: PidStatsBase(name, store_, lowSlots_, highSlots_, W)
+	{
+		static_assert(W>1, "PidStats window needs 2 or more samples");
+	}
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "application.h"
+#include "myPids.h"
+
+// class PidInfo
+// functions
+// Engineering value from the data bytes A, B, ...
+long PidInfo::decode(const ByteSpan A) const
+{
+	uint32_t raw = 0UL;
+	for ( uint8_t i=0; i<bytes; i++ ) raw = (raw<<8) | A[i];
+	return (long)(raw>>shift) + offset;
+}
+
+// Display value, rounded to nearest.  64 bit product so 65535 km still fits
+long PidInfo::display(const long value) const
+{
+	return (long)(((int64_t)value*scale + 0x800000)>>24) + add;
+}
+
+// Right aligned display value and unit, or dashes in the same columns if !ok
+void PidInfo::format(const long value, const bool ok, TextBuf *str) const
+{
+	if ( ok ) str->addInt(display(value), width);
+	else
+	{
+		for ( uint8_t i=4; i<width; i++ ) str->add(' ');
+		str->add("----");
+	}
+	str->add(unit);
+}
@@ -0,0 +1,36 @@
+#ifndef _myPids_h
+#define _myPids_h
+
+#include <stdint.h>
+#include "myFormat.h"
+#include "myResponse.h"
+
+// Fixed point factor with 24 fraction bits.  Folded by the compiler, so tables
+// built with it carry no float code onto the Photon
+#define Q24(x) 	((int32_t)((x)*16777216.0+0.5))
+
+#define KPH_MPH 	Q24(0.621371)   // Also km to mi
+#define C_F 			Q24(1.8)
+
+// Registry entry for a mode 01 PID:  how to turn its data bytes into engineering
+// units and how to show them, all in integer arithmetic.
+//   value = (A..bytes >> shift) + offset            e.g. quarter rpm, C from A-40
+//   shown = round(value*scale/2^24) + add           e.g. kph to mph, C to F
+class PidInfo
+{
+public:
+	const char 	*pid;         // Request, e.g. "010C"
+	const char 	*jump;        // Jumper reply, decimal
+	const char 	*unit;        // Display suffix
+	uint8_t 		bytes;        // Data bytes after mode and PID, big endian
+	uint8_t 		shift;
+	int16_t 		offset;
+	int32_t 		scale;        // Q24, up to 127
+	int16_t 		add;
+	uint8_t 		width;        // Shown value right aligned in this many characters
+	long decode(const ByteSpan A) const;
+	long display(const long value) const;
+	void format(const long value, const bool ok, TextBuf *str) const;
+};
+
+#endif
@@ -1,66 +1,103 @@
 #include "application.h"
 #include "myQueue.h"
+#include "myDtcStats.h"
+#include "myFreeze.h"
 
-// class Queue
+// class QueueBase
 // constructors
-Queue::Queue()
-: front_(-1), rear_(-1), maxSize_(0), gmt_(0), name_(""), storing_(true), verbose_(0)
-{}
-Queue::Queue(const int maxSize, const int GMT, const String name, const bool storing, const int verbose)
-: front_(-1), rear_(-1), maxSize_(maxSize), gmt_(GMT), name_(name), storing_(true), verbose_(verbose)
+QueueBase::QueueBase(FaultCode *A, const int maxSize, uint16_t *index, const int indexSize, JournalRecord *pending,\
+	const int journalSize, uint32_t *dirtyBits, const int GMT, const char *name, const bool storing, const int verbose)
+: front_(-1), rear_(-1), maxSize_(maxSize), gmt_(GMT), name_(name), storing_(storing), A_(A), verbose_(verbose),
+	index_(index), indexSize_(indexSize), indexUsed_(0), indexTombs_(0), active_(0), inactive_(0), stale_(false),
+	pending_(pending), journalSize_(journalSize), journalUsed_(0), pendingN_(0), base_(0UL), compact_(true),
+	journaling_(true), wipe_(true), dirty_(dirtyBits), nvmBytes_(0UL), nvmWrites_(0UL), stats_(NULL),
+	frames_(NULL)
 {
-	A_ 				= new FaultCode[maxSize_];
-}
-Queue::Queue(const int front, const int rear, const int maxSize, const int GMT, const String name, const bool storing, const int verbose)
-: front_(front), rear_(rear), maxSize_(maxSize), gmt_(GMT), name_(name), storing_(storing), verbose_(verbose)
-{
-	A_ 				= new FaultCode[maxSize_];
+	indexClear();
+	dirty(0, true);
 }
 
 // operators
 
 // functions
 // Clears NVM by reinitting the pointers
-int Queue::clearNVM(int start)
+int QueueBase::clearNVM(int start)
 {
-	int p = start;
-	FaultCode val;
-	val.time = 0UL; val.code = 0UL; val.reset = false;
-	EEPROM.put(p, int(-1)); 	p += sizeof(int);
-	EEPROM.put(p, int(-1));		p += sizeof(int);
-	EEPROM.put(p, maxSize_);	p += sizeof(int);
-	for ( uint8_t i=0; i<maxSize_; i++ )
-	{
-		EEPROM.put(p, val); p += sizeof(FaultCode);
-	}
-	// verify
-	int test;
-	FaultCode tc;
-	p = start;
-	EEPROM.get(p, test); Serial.printf("%d",test);if ( test!=-1   			) return -1; p += sizeof(int);
-	EEPROM.get(p, test); Serial.printf("%d",test);if ( test!=-1   			) return -1; p += sizeof(int);
-	EEPROM.get(p, test); Serial.printf("%d",test);if ( test!=maxSize_ 	) return -1; p += sizeof(int);
-	for ( uint8_t i=0; i<maxSize_; i++ )
+	base_ += journalUsed_ + 1;  // Orphans the old journal
+	writeSnapshot(start, true);
+	dirty(0, true);  // NVM now differs in every slot
+	wipeJournal(start);
+	journalUsed_ = 0;
+	pendingN_ 	 = 0;
+	compact_ 		 = true;  // RAM no longer matches the snapshot
+	if ( verbose_>4 && checkNVM(start, NVM_QUEUE_MAGIC, NVM_QUEUE_VERSION, snapshotSize()) ) Serial.printf("Verified clear.\n");
+	return start + nvmSize();
+}
+
+// Report every sighting in newCode to stats
+void QueueBase::attach(DtcStatsBase *stats)
+{
+	stats_ = stats;
+}
+
+// Report every newly logged code in newCode to frames
+void QueueBase::attach(FreezeFramesBase *frames)
+{
+	frames_ = frames;
+}
+
+// Walk front to rear over the entries in view
+QueueRange QueueBase::codes(const QueueView view)
+{
+	return QueueRange(QueueIter(A_, front_, size(), maxSize_, 1, view), QueueIter(A_, 0, 0, maxSize_, 1, view));
+}
+
+// Walk rear to front, newest first, over the entries in view
+QueueRange QueueBase::codesReverse(const QueueView view)
+{
+	return QueueRange(QueueIter(A_, rear_, size(), maxSize_, -1, view), QueueIter(A_, 0, 0, maxSize_, -1, view));
+}
+
+// Mark all slots as matching the NVM snapshot
+void QueueBase::clean()
+{
+	for ( int w=0; w<(maxSize_+31)/32; w++ ) dirty_[w] = 0UL;
+}
+
+// Mark slot i, or all slots, as differing from the NVM snapshot
+void QueueBase::dirty(const int i, const bool all)
+{
+	if ( all )
 	{
-		EEPROM.get(p, tc);
-		Serial.printf("%u P%04u %d\n", tc.time, tc.code, tc.reset);
-		if ( tc.time!=val.time || tc.code!=val.code || tc.reset!=val.reset ) return -1;
-		p += sizeof(FaultCode);
+		for ( int w=0; w<(maxSize_+31)/32; w++ ) dirty_[w] = 0xFFFFFFFFUL;
+		return;
 	}
-	if ( verbose_>4 ) Serial.printf("Verified clear.\n");
-	return p;
+	if ( i>=0 && i<maxSize_ ) dirty_[i>>5] |= 1UL<<(i&31);
+}
+
+// True if slot i must be rewritten with the next snapshot
+bool QueueBase::isDirty(const int i)
+{
+	return dirty_[i>>5] & (1UL<<(i&31));
 }
 
 // Removes an element in Queue from front_ end.
-void Queue::Dequeue()
+void QueueBase::Dequeue()
 {
 	if ( verbose_>4 ) Serial.printf("Dequeuing \n");
 	if(IsEmpty())
 	{
-		if ( verbose_>0 ) Serial.println(name_ + ": empty queue");
+		if ( verbose_>0 ) Serial.printf("%s: empty queue\n", name_);
 		return;
 	}
-	else if(front_ == rear_ )
+	if ( !A_[front_].reset )
+	{
+		active_--;
+		indexErase(A_[front_].code);
+	}
+	else inactive_--;
+	journal(JOURNAL_DEQUEUE, A_[front_]);
+	if(front_ == rear_ )
 	{
 		rear_ = front_ = -1;
 	}
@@ -68,15 +105,18 @@ void Queue::Dequeue()
 	{
 		front_ = (front_+1)%maxSize_;
 	}
+#ifdef QUEUE_DEBUG
+	checkInvariants("Dequeue");
+#endif
 }
 
 // Inserts an element in queue at rear_ end
-void Queue::Enqueue(const FaultCode x)
+void QueueBase::Enqueue(const FaultCode x)
 {
 	Serial.printf("Enqueuing P%04u\n", x.code);
 	if(IsFull())
 	{
-		if ( verbose_>0 ) Serial.println(name_ + ": queue is full");
+		if ( verbose_>0 ) Serial.printf("%s: queue is full\n", name_);
 		return;
 	}
 	if (IsEmpty())
@@ -88,15 +128,29 @@ void Queue::Enqueue(const FaultCode x)
 	    rear_ = (rear_+1)%maxSize_;
 	}
 	A_[rear_] = FaultCode(x);
+	dirty(rear_);
+	if ( !x.reset )
+	{
+		active_++;
+		indexInsert(x.code);
+	}
+	else inactive_++;
+	journal(JOURNAL_ENQUEUE, x);
+#ifdef QUEUE_DEBUG
+	checkInvariants("Enqueue");
+#endif
 }
 
 // Inserts an element in queue at rear_ end.  Pops one off if full
-void Queue::EnqueueOver(const FaultCode x)
+void QueueBase::EnqueueOver(const FaultCode x)
 {
 	if ( verbose_>4 ) Serial.printf("Enqueuing %u\n", x.code);
 	if(IsFull())
 	{
-		Queue::Dequeue();
+		bool journaling = journaling_;
+		journaling_ = false;  // Replay of the enqueue pops it again
+		QueueBase::Dequeue();
+		journaling_ = journaling;
 	}
 	if (IsEmpty())
 	{
@@ -107,30 +161,148 @@ void Queue::EnqueueOver(const FaultCode x)
 	    rear_ = (rear_+1)%maxSize_;
 	}
 	A_[rear_] = x;
+	dirty(rear_);
+	if ( !x.reset )
+	{
+		active_++;
+		indexInsert(x.code);
+	}
+	else inactive_++;
+	journal(JOURNAL_ENQUEUE, x);
+#ifdef QUEUE_DEBUG
+	checkInvariants("EnqueueOver");
+#endif
 }
 
 // Returns element at front_ of queue.
-FaultCode Queue::Front()
+FaultCode QueueBase::Front()
 {
 	if(front_ == -1)
 	{
-		if ( verbose_>0 ) Serial.println(name_ + ": no front; empty queue");
+		if ( verbose_>0 ) Serial.printf("%s: no front; empty queue\n", name_);
 		return FaultCode(0UL, 0UL);
 	}
 	return A_[front_];
 }
 
 // Returns front_ value.
-int Queue::front()
+int QueueBase::front()
 {
 	return front_;
 }
 
 
+// Empty the code index
+void QueueBase::indexClear()
+{
+	for ( int i=0; i<indexSize_; i++ ) index_[i] = 0U;
+	indexUsed_ 	= 0;
+	indexTombs_ = 0;
+	stale_ = false;
+}
+
+// Remove one instance of an unreset code from the index
+void QueueBase::indexErase(const unsigned long cod)
+{
+	if ( cod==0UL || cod>=0xFFFFUL || stale_ ) return;
+	int mask = indexSize_-1;
+	for ( int i=indexHome(cod); index_[i]!=0U; i=(i+1)&mask )
+	{
+		if ( index_[i]==cod )
+		{
+			index_[i] = 0xFFFFU;
+			indexUsed_--;
+			indexTombs_++;
+			return;
+		}
+	}
+}
+
+// True if an unreset instance of code is queued
+bool QueueBase::indexFind(const unsigned long cod)
+{
+	if ( stale_ ) refresh();
+	if ( cod==0UL || cod>=0xFFFFUL ) return false;
+	int mask = indexSize_-1;
+	for ( int i=indexHome(cod); index_[i]!=0U; i=(i+1)&mask )
+	{
+		if ( index_[i]==cod ) return true;
+	}
+	return false;
+}
+
+// First slot to probe for code
+int QueueBase::indexHome(const unsigned long cod)
+{
+	uint32_t h = (uint32_t)cod*2654435761UL;  // Fibonacci hashing
+	h ^= h>>16;
+	return (int)(h & (indexSize_-1));
+}
+
+// Add an unreset code to the index.  Repeats are kept, so erase removes one
+void QueueBase::indexInsert(const unsigned long cod)
+{
+	if ( cod==0UL || cod>=0xFFFFUL || stale_ ) return;
+	int mask = indexSize_-1;
+	int i = indexHome(cod);
+	while ( index_[i]!=0U && index_[i]!=0xFFFFU ) i = (i+1)&mask;
+	if ( index_[i]==0xFFFFU ) indexTombs_--;
+	index_[i] = cod;
+	indexUsed_++;
+	if ( 4*(indexUsed_+indexTombs_) > 3*indexSize_ ) indexRebuild();  // Keep probes short
+}
+
+// Rebuild the index from the queue, dropping deleted slots
+void QueueBase::indexRebuild()
+{
+	indexClear();
+	for ( FaultCode &fc : codes(activeCodes) ) indexInsert(fc.code);
+}
+
+// Remember a change for the next storeNVM.  Too many changes force a snapshot
+void QueueBase::journal(const uint8_t op, const FaultCode x)
+{
+	if ( !journaling_ || !storing_ || compact_ ) return;
+	if ( pendingN_>=journalSize_ )
+	{
+		compact_ 	= true;
+		pendingN_ = 0;
+		return;
+	}
+	pending_[pendingN_].op 	= op;
+	pending_[pendingN_].rec = x.record();
+	pending_[pendingN_].seq = 0UL;
+	pendingN_++;
+}
+
+#ifdef QUEUE_DEBUG
+// Compare counters and code index with a full scan.  True if consistent
+bool QueueBase::checkInvariants(const char *where)
+{
+	if ( stale_ ) return true;
+	int nAct = 0;
+	int nInAct = 0;
+	bool indexed = true;
+	for ( FaultCode &fc : codes() )
+	{
+		if ( fc.reset ) nInAct++;
+		else
+		{
+			nAct++;
+			if ( fc.code>0UL && fc.code<0xFFFFUL && !indexFind(fc.code) ) indexed = false;
+		}
+	}
+	if ( nAct==active_ && nInAct==inactive_ && indexed ) return true;
+	Serial.printf("%s::%s invariant broken:  active %d ?= %d, inactive %d ?= %d, indexed %d\n", name_, where,\
+		active_, nAct, inactive_, nInAct, indexed);
+	return false;
+}
+#endif
+
 // Return queue to memory
-FaultCode Queue::getRaw(const uint8_t i)
+FaultCode QueueBase::getRaw(const int i)
 {
-	if ( i>= maxSize_ )
+	if ( i<0 || i>=maxSize_ )
 	{
 		if ( verbose_>1 ) Serial.printf("Request ignored: %d\n", i);
 		return FaultCode(0UL, 0UL);
@@ -139,64 +311,99 @@ FaultCode Queue::getRaw(const uint8_t i)
 }
 
 // To check wheter Queue is empty or not
-bool Queue::IsEmpty()
+bool QueueBase::IsEmpty()
 {
 	return (front_ == -1 && rear_ == -1);
 }
 
 // To check whether Queue is full or not
-bool Queue::IsFull()
+bool QueueBase::IsFull()
 {
 	return (rear_+1)%maxSize_ == front_ ? true : false;
 }
 
 // Load queue from memory
-int Queue::loadRaw(const uint8_t i, const FaultCode x)
+int QueueBase::loadRaw(const int i, const FaultCode x)
 {
-	if ( i>= maxSize_ )
+	if ( i<0 || i>=maxSize_ )
 	{
 		if ( verbose_>1 ) Serial.printf("Entry ignored:  %d\n", i);
 		return -1;
 	}
 	A_[i] = x;
+	dirty(i);
+	stale_ = true;
+	if ( journaling_ ) compact_ = true;  // Not expressible as a journal change
 	return 0;
 }
 
-// Load fault queue from eeprom to prom
-int Queue::loadNVM(const int start)
+// Load fault queue from eeprom to prom.  One CRC pass validates the snapshot
+int QueueBase::loadNVM(const int start)
 {
-	int p = start;
+	bool intact = checkNVM(start, NVM_QUEUE_MAGIC, NVM_QUEUE_VERSION, snapshotSize());
+	int p = start + sizeof(NvmHeader);
 	int front; 		EEPROM.get(p, front); 	p += sizeof(int);
 	int rear;   	EEPROM.get(p, rear);  	p += sizeof(int);
 	int maxSize; 	EEPROM.get(p, maxSize); p += sizeof(int);
-	if ( verbose_>3 ) Serial.printf("%s::loadNVM:  front, rear, maxSize:  %d,%d,%d\n", name_.c_str(), front, rear, maxSize);  delay(2000);
-	if ( maxSize==maxSize_	&&					\
-	front<=maxSize_ 	&& front>=-1 &&		 \
-	rear<=maxSize_  	&& rear>=-1 )
+	uint32_t base; EEPROM.get(p, base); p += sizeof(uint32_t);
+	if ( verbose_>3 ) Serial.printf("%s::loadNVM:  intact, front, rear, maxSize, base:  %d,%d,%d,%d,%lu\n", name_, intact, front, rear, maxSize, base);
+	if ( intact && maxSize==maxSize_	&&		\
+	front<maxSize_ 	&& front>=-1 &&		 \
+	rear<maxSize_  	&& rear>=-1 )
 	{
+		journaling_ = false;
 		front_ 		= front;
 		rear_ 		= rear;
 		maxSize_ 	= maxSize;
-		for ( uint8_t i=0; i<maxSize_; i++ )
+		for ( int i=0; i<maxSize_; i++ )
 		{
-			unsigned long tim;
-			FaultCode fc;
-			EEPROM.get(p, fc); p += sizeof(FaultCode);
+			FaultRecord rec;
+			EEPROM.get(p, rec); p += sizeof(FaultRecord);
+			FaultCode fc(rec);
 			if ( verbose_>3 && verbose_<6 ) Serial.printf("%u P%04u %d\n", fc.time, fc.code, fc.reset);
 			if ( verbose_>5 )	fc.Print();
 			loadRaw(i, fc);
 		}
 		if ( verbose_>5 ) Serial.printf("\n");
+		clean();  // RAM matches snapshot until replay
+
+		// Replay journal
+		int n = 0;
+		bool good = true;
+		for ( ; n<journalSize_ && good; n++ )
+		{
+			JournalRecord J;
+			EEPROM.get(p + n*sizeof(JournalRecord), J);
+			if ( J.seq!=base+1+n ) break;
+			if ( verbose_>3 ) Serial.printf("%s::loadNVM:  replay %lu op %d P%04u\n", name_, J.seq, J.op, J.rec.code);
+			switch ( J.op )
+			{
+				case JOURNAL_ENQUEUE: 	EnqueueOver(FaultCode(J.rec)); 	break;
+				case JOURNAL_DEQUEUE: 	Dequeue(); 											break;
+				case JOURNAL_RESETALL: 	resetAll(); 										break;
+				default: 								good = false; 									break;
+			}
+		}
+		if ( !good ) n--;
+		base_ 			 = base;
+		journalUsed_ = n;
+		pendingN_ 	 = 0;
+		compact_ 		 = !good;
+		journaling_  = true;
+		wipe_ 			 = false;
 	}
 	else
 	{
-		Serial.printf("NVM uninitialized...reinit...\n");
+		Serial.printf("%s NVM uninitialized, old format or corrupt...reinit...\n", name_);
+		dirty(0, true);
+		compact_ = true;
+		wipe_ 	 = true;
 	}
-	return p;
+	return start + nvmSize();
 }
 
 // Returns front_ value.
-int Queue::maxSize()
+int QueueBase::maxSize()
 {
 	if(front_ == -1)
 	{
@@ -206,18 +413,18 @@ int Queue::maxSize()
 }
 
 // Returns name
-String Queue::name()
+const char *QueueBase::name()
 {
 	return name_;
 }
 
-// Add a fault
-void Queue::newCode(const unsigned long tim, const unsigned long cod)
+// Add a fault.  True if newly logged, false if already active
+bool QueueBase::newCode(const unsigned long tim, const unsigned long cod)
 {
 	FaultCode newOne 	= FaultCode(tim, cod, false); // false, by definition new
 	FaultCode front 	= Front();
 	FaultCode rear 		= Rear();
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;
+	int count = size();
 	if ( verbose_>4 )
 	{
 		Serial.printf("Front is ");  front.Print(); Serial.printf("\n");
@@ -225,24 +432,19 @@ void Queue::newCode(const unsigned long tim, const unsigned long cod)
 		Serial.printf("Count is %d\n", count);
 		Serial.printf("Checking for %u P%04u\n", tim, cod);
 	}
+	if ( stats_ ) stats_->record(tim, cod);
 	// Queue inserts at rear (FIFO)
-	bool haveIt = false;
-	int i = 0;
-	while ( !haveIt && i<count )
-	{
-		uint8_t index = (front_+i)%maxSize_; // Index of element while travesing circularly from front_
-		if ( !A_[index].reset && (A_[index].code==newOne.code) ) haveIt = true;
-		if ( verbose_>4 ) Serial.printf("Candidate: reset=%d code=P%04u \n", A_[index].reset, A_[index].code);
-		i++;
-	}
+	bool haveIt = indexFind(cod);
 	if ( !haveIt )
 	{
 		EnqueueOver(newOne);
+		if ( frames_ ) frames_->trigger(tim, cod);
 		if ( verbose_>2 )
 		{
 			Serial.printf("newCode:      ");
 			Print();
 		}
+		return true;
 	}
 	else
 	{
@@ -253,179 +455,260 @@ void Queue::newCode(const unsigned long tim, const unsigned long cod)
 			Serial.printf("\n");
 		}
 	}
+	return false;
+}
+
+// Returns EEPROM bytes written since boot
+unsigned long QueueBase::nvmBytes()
+{
+	return nvmBytes_;
+}
+
+// Returns EEPROM puts since boot
+unsigned long QueueBase::nvmWrites()
+{
+	return nvmWrites_;
+}
+
+// Returns NVM footprint, bytes
+int QueueBase::nvmSize()
+{
+	return sizeof(NvmHeader) + snapshotSize() + journalSize_*sizeof(JournalRecord);
 }
 
 // Print
-void Queue::Print()
+void QueueBase::Print()
 {
-	//Finding number of elements in queue
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;
-	Serial.print(name_ + " ");
+	Serial.printf("%s ", name_);
 	if ( verbose_>4 ) Serial.printf("front, rear, maxSize: %d  %d  %d:", front_, rear_, maxSize_);
-	for(int i = 0; i <count; i++)
-	{
-		int index = (front_+i)%maxSize_; // Index of element while travesing circularly from front_
-		Serial.printf("| %u P%04u %d ", A_[index].time, A_[index].code, A_[index].reset);
-	}
-	if ( count>0 ) Serial.printf("\n");
+	for ( FaultCode &fc : codes() ) fc.Print();
+	if ( !IsEmpty() ) Serial.printf("\n");
 }
 
 
-// Determine number of active (unreset) codes.  This cannot be an internal variable because of Dequeuing.
-int Queue::numActive()
+// Number of active (unreset) codes.  Kept by enqueue, dequeue and reset
+int QueueBase::numActive()
 {
-	int nAct = 0;
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;  // # elements in queue
-	for(int i = 0; i <count; i++)
-	{
-		int index = (front_+i) % maxSize_; // Index of element while travesing circularly from front_
-		if ( !A_[index].reset )
-		{
-			nAct++;
-		}
-	}
-	return nAct;
+	if ( stale_ ) refresh();
+	return active_;
+}
+
+// Number of inactive (reset) codes
+int QueueBase::numInActive()
+{
+	if ( stale_ ) refresh();
+	return inactive_;
 }
 
 
-// Determine if any reset !=0.  This cannot be an internal variable because of Dequeuing.
-int Queue::printActive()
+// Print active codes to Serial.  Stops once all active codes are found
+int QueueBase::printActive()
 {
 	int nAct = 0;
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;  // # elements in queue
-	for(int i = 0; i <count; i++)
+	if ( numActive()==0 ) return 0;
+	Time.zone(gmt_);
+	for ( FaultCode &fc : codes(activeCodes) )
 	{
-		int index = (front_+i) % maxSize_; // Index of element while travesing circularly from front_
-		if ( !A_[index].reset )
-		{
-			nAct++;
-			unsigned long t = A_[index].time;
-			Time.zone(gmt_);
-			String codeTime = Time.format(A_[index].time, "%D-%H:%M");
-			Serial.printf("%s P%04u\n", codeTime.c_str(), A_[index].code);
-		}
+		unsigned long t = fc.time;
+		Serial.printf("%02d/%02d/%02d-%02d:%02d P%04u\n", Time.month(t), Time.day(t), Time.year(t)%100,\
+			Time.hour(t), Time.minute(t), fc.code);
+		if ( ++nAct==active_ ) break;
 	}
 	return nAct;
 }
 
 
-// Determine if any reset !=0.  This cannot be an internal variable because of Dequeuing.
-int Queue::printActive(String *str)
+// List active codes.  Stops once all active codes are found
+int QueueBase::printActive(TextBuf *str)
 {
 	int nAct = 0;
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;  // # elements in queue
-	*str = "";
-	for(int i = 0; i <count; i++)
+	str->clear();
+	if ( numActive()==0 )
 	{
-		int index = (front_+i) % maxSize_; // Index of element while travesing circularly from front_
-		if ( !A_[index].reset )
-		{
-			nAct++;
-			unsigned long t = A_[index].time;
-			Time.zone(gmt_);
-			char c_str[20];
-			sprintf(c_str, "P%04u ", A_[index].code);
-			//*str += "P" + String(A_[index].code) + " ";
-			*str += String(c_str);
-		}
+		str->add("----  ");
+		return 0;
+	}
+	for ( FaultCode &fc : codes(activeCodes) )
+	{
+		str->add('P').addUns(fc.code, 4, '0').add(' ');
+		if ( ++nAct==active_ ) break;
 	}
-	if ( nAct==0 ) *str = "----  ";
 	return nAct;
 }
 
-// Print last num reset
-int  Queue::printInActive(String *str, const int num)
+// List last num reset, newest first
+int  QueueBase::printInActive(TextBuf *str, const int num)
 {
 	int nInAct = 0;
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;  // # elements in queue
-	*str = "";
-	for(int i=0; (i<count&&nInAct<num); i++)
+	str->clear();
+	int want = num<numInActive() ? num : inactive_;
+	if ( want<=0 ) return 0;
+	Time.zone(gmt_);
+	for ( FaultCode &fc : codesReverse(resetCodes) )
 	{
-		int index = (rear_-i) % maxSize_; // Index of element while travesing circularly from front_
-		if ( A_[index].reset )
-		{
-			nInAct++;
-			unsigned long t = A_[index].time;
-			Time.zone(gmt_);
-			char c_str[20];
-			sprintf(c_str, "%04u", A_[index].code);
-			*str += String(Time.year(t));
-			if ( Time.month(t)<10 ) *str += "0";
-			*str += String(Time.month(t));
-			if ( Time.day(t)<10 ) 	*str += "0";
-			*str += String(Time.day(t))	+ "    P" + String(c_str) + String("\n");
-			if ( verbose_>4 ) Serial.printf("%s::printInActive:  %u %u\n", name_.c_str(), A_[index].time, A_[index].code);
-		}
+		unsigned long t = fc.time;
+		str->addInt(Time.year(t)).addInt(Time.month(t), 2, '0').addInt(Time.day(t), 2, '0');
+		str->add("    P").addUns(fc.code, 4, '0').add('\n');
+		if ( verbose_>4 ) Serial.printf("%s::printInActive:  %u %u\n", name_, fc.time, fc.code);
+		if ( ++nInAct==want ) break;
 	}
 	return nInAct;
 }
 
 // Returns element at front_ of queue.
-FaultCode Queue::Rear()
+FaultCode QueueBase::Rear()
 {
 	if(rear_ == -1)
 	{
-		if ( verbose_>0 ) Serial.println(name_ + ": no rear; empty queue");
+		if ( verbose_>0 ) Serial.printf("%s: no rear; empty queue\n", name_);
 		return FaultCode(0UL, 0UL);
 	}
 	return A_[rear_];
 }
 
-// Returns front_ value.
-int Queue::rear()
+// Returns rear_ value.
+int QueueBase::rear()
 {
 	return rear_;
 }
 
-// Reset all fault codes
-int Queue::resetAll()
+// Number of queued entries
+int QueueBase::size()
+{
+	if ( IsEmpty() ) return 0;
+	int count = rear_-front_+1;
+	return count>0 ? count : count+maxSize_;
+}
+
+// Reset all fault codes.  Returns number newly reset
+int QueueBase::resetAll()
+{
+	if ( stale_ ) refresh();
+	int nReset = active_;
+	QueueRange act = codes(activeCodes);
+	for ( QueueIter it=act.begin(); it!=act.end(); ++it )
+	{
+		it->reset = true;
+		dirty(it.index());
+	}
+	active_ 	= 0;
+	inactive_ = size();
+	indexClear();
+	if ( nReset>0 ) journal(JOURNAL_RESETALL, FaultCode());
+#ifdef QUEUE_DEBUG
+	checkInvariants("resetAll");
+#endif
+	return nReset;
+}
+
+// Recount and reindex after raw loads
+void QueueBase::refresh()
 {
-	int count = (rear_+maxSize_-front_)%maxSize_ + 1;
-	for ( int i=0; i<count; i++ )
+	active_ 	= 0;
+	inactive_ = 0;
+	for ( FaultCode &fc : codes() )
 	{
-		int index = (front_+i) % maxSize_; // Index of element while travesing circularly from front_
-		A_[index].reset = true;
+		if ( fc.reset ) inactive_++;
+		else active_++;
 	}
+	indexRebuild();
 }
 
-// Store in NVM
-int Queue::storeNVM(const int start)
+// Store in NVM.  Appends the changes since the last store, or rewrites the
+// snapshot when the journal is full.  Nothing is written when unchanged
+int QueueBase::storeNVM(const int start)
 {
 	if ( !storing_ )
 	{
-		if ( verbose_>0 ) Serial.println(name_ + ":  not storing NVM");
+		if ( verbose_>0 ) Serial.printf("%s:  not storing NVM\n", name_);
 		return start;
 	}
-	int p = start;
-	EEPROM.put(p, front_); 		p += sizeof(int);
-	EEPROM.put(p, rear_ );		p += sizeof(int);
-	EEPROM.put(p, maxSize_);	p += sizeof(int);
-	for ( uint8_t i=0; i<maxSize_; i++ )
-	{
-		FaultCode val = getRaw(i);
-		if ( verbose_>4 ) Serial.printf("%u P%04u %d\n", val.time, val.code, val.reset);
-		EEPROM.put(p, val); p += sizeof(FaultCode);
-	}
-	// verify
-	int test;
-	bool success = true;
-	FaultCode tc, raw;
-	p = start;
-	EEPROM.get(p, test); if ( test!=front_   ) success = false; p += sizeof(int);
-	if ( verbose_>5 ) Serial.printf("%s read %d ?= %d demand\n", name_.c_str(), test, front_);
-	EEPROM.get(p, test); if ( test!=rear_    ) success = false; p += sizeof(int);
-	if ( verbose_>5 ) Serial.printf("%s read %d ?= %d demand\n", name_.c_str(), test, rear_);
-	EEPROM.get(p, test); if ( test!=maxSize_ ) success = false; p += sizeof(int);
-	if ( verbose_>5 ) Serial.printf("%s read %d ?= %d demand\n", name_.c_str(), test, maxSize_);
-	for ( uint8_t i=0; i<maxSize_; i++ )
-	{
-		FaultCode raw = getRaw(i);
-		EEPROM.get(p, tc);
-		if ( tc.time!=raw.time || tc.code!=raw.code || tc.reset!=raw.reset ) success = false;
-		if ( verbose_>5 ) Serial.printf("%s read time %u ?= %u demand, code %u ?= %u, reset %d ?= %d\n", name_.c_str(), tc.time, raw.time, tc.code, raw.code, tc.reset, raw.reset);
-		p += sizeof(FaultCode);
-	}
-	if ( verbose_>4 && success ) Serial.printf("%s Verified.\n", name_.c_str());
-	if ( success ) return p;
-	else 					 return -1;
+	if ( compact_ || journalUsed_+pendingN_>journalSize_ ) return storeSnapshot(start);
+	return storeJournal(start);
+}
+
+// Append pending changes to the journal
+int QueueBase::storeJournal(const int start)
+{
+	int p = start + sizeof(NvmHeader) + snapshotSize() + journalUsed_*sizeof(JournalRecord);
+	for ( int i=0; i<pendingN_; i++ )
+	{
+		pending_[i].seq = base_ + 1 + journalUsed_ + i;
+		if ( verbose_>4 ) Serial.printf("%s journal %lu op %d P%04u\n", name_, pending_[i].seq, pending_[i].op, pending_[i].rec.code);
+		EEPROM.put(p, pending_[i]); p += sizeof(JournalRecord);
+	}
+	nvmBytes_ 	 += pendingN_*sizeof(JournalRecord);
+	nvmWrites_ 	 += pendingN_;
+	journalUsed_ += pendingN_;
+	pendingN_ 		= 0;
+	return start + nvmSize();
+}
+
+// Snapshot body size, bytes:  front, rear, maxSize, base then records
+int QueueBase::snapshotSize()
+{
+	return 3*sizeof(int) + sizeof(uint32_t) + maxSize_*sizeof(FaultRecord);
+}
+
+// Rewrite the whole queue as a new snapshot with an empty journal
+int QueueBase::storeSnapshot(const int start)
+{
+	base_ += journalUsed_ + pendingN_ + 1;  // Orphans the old journal
+	writeSnapshot(start, false);
+	if ( wipe_ ) wipeJournal(start);
+	journalUsed_ = 0;
+	pendingN_ 	 = 0;
+	compact_ 		 = false;
+	if ( verbose_>4 && checkNVM(start, NVM_QUEUE_MAGIC, NVM_QUEUE_VERSION, snapshotSize()) ) Serial.printf("%s Verified.\n", name_);
+	return start + nvmSize();
+}
+
+// Write snapshot body then its header.  Only dirty slots are put; the CRC
+// covers all of them from RAM.  empty writes a cleared queue
+void QueueBase::writeSnapshot(const int start, const bool empty)
+{
+	int front = empty ? -1 : front_;
+	int rear 	= empty ? -1 : rear_;
+	uint32_t crc = 0UL;
+	int p = start + sizeof(NvmHeader);
+	EEPROM.put(p, front); 		crc = crc32(crc, &front, sizeof(int)); 			p += sizeof(int);
+	EEPROM.put(p, rear);			crc = crc32(crc, &rear, sizeof(int)); 			p += sizeof(int);
+	EEPROM.put(p, maxSize_);	crc = crc32(crc, &maxSize_, sizeof(int)); 	p += sizeof(int);
+	EEPROM.put(p, base_);			crc = crc32(crc, &base_, sizeof(uint32_t)); p += sizeof(uint32_t);
+	int nPut = 0;
+	for ( int i=0; i<maxSize_; i++ )
+	{
+		FaultRecord rec = empty ? FaultCode().record() : A_[i].record();
+		crc = crc32(crc, &rec, sizeof(FaultRecord));
+		if ( empty || isDirty(i) )
+		{
+			if ( verbose_>4 && !empty ) Serial.printf("%u P%04u %d\n", A_[i].time, A_[i].code, A_[i].reset);
+			EEPROM.put(p, rec);
+			nPut++;
+		}
+		p += sizeof(FaultRecord);
+	}
+	if ( !empty ) clean();
+	sealNVM(start, NVM_QUEUE_MAGIC, NVM_QUEUE_VERSION, snapshotSize(), crc);
+	nvmBytes_ 	+= sizeof(NvmHeader) + 3*sizeof(int) + sizeof(uint32_t) + nPut*sizeof(FaultRecord);
+	nvmWrites_ 	+= 5 + nPut;
+	if ( verbose_>3 ) Serial.printf("%s snapshot wrote %d of %d slots\n", name_, nPut, maxSize_);
+}
+
+// Zero every journal slot.  Needed once when the region held something else,
+// afterwards sequence numbers alone tell old slots from new
+void QueueBase::wipeJournal(const int start)
+{
+	JournalRecord J;
+	J.op 	= 0;
+	J.rec = FaultCode().record();
+	J.seq = 0UL;
+	int p = start + sizeof(NvmHeader) + snapshotSize();
+	for ( int i=0; i<journalSize_; i++ )
+	{
+		EEPROM.put(p, J); p += sizeof(JournalRecord);
+	}
+	nvmBytes_ 	+= journalSize_*sizeof(JournalRecord);
+	nvmWrites_ 	+= journalSize_;
+	wipe_ = false;
 }
@@ -1,6 +1,38 @@
 #ifndef _myQueue_h
 #define _myQueue_h
 
+#include "myFormat.h"
+#include "myNvm.h"
+
+// Check counters and code index against a full scan after every change.  Usually commented
+// #define QUEUE_DEBUG
+
+// Packed EEPROM image of a FaultCode, 7 bytes instead of 12.  Codes are validated
+// below 3500 on receipt so 16 bits hold them.
+#define FAULT_RESET 0x01  // FaultRecord flags bit
+struct __attribute__((packed)) FaultRecord
+{
+	uint32_t time;
+	uint16_t code;
+	uint8_t  flags;
+};
+
+// NVM snapshot format, bump version on any layout change
+#define NVM_QUEUE_MAGIC 	0x51554546UL  // "FEUQ"
+#define NVM_QUEUE_VERSION 2
+
+// NVM journal record:  one queue change appended by storeNVM and replayed by
+// loadNVM.  seq is last so a torn append does not look valid.
+#define JOURNAL_ENQUEUE 	1
+#define JOURNAL_DEQUEUE 	2
+#define JOURNAL_RESETALL 	3
+struct __attribute__((packed)) JournalRecord
+{
+	uint8_t 		op;
+	FaultRecord rec;
+	uint32_t 		seq;
+};
+
 class FaultCode
 {
 public:
@@ -25,6 +57,12 @@ public:
 		code 	= cod;
 		reset = false;
 	}
+	FaultCode(const FaultRecord & R)
+	{
+		time 	= R.time;
+		code 	= R.code;
+		reset = R.flags & FAULT_RESET;
+	}
 	FaultCode (const FaultCode & FC)
 	{
 		time 	= FC.time;
@@ -53,6 +91,14 @@ public:
 		if ( time == B.time && code == B.code ) return true;
 		return false;
 	}
+	FaultRecord record() const
+	{
+		FaultRecord R;
+		R.time 	= time;
+		R.code 	= code<0xFFFFUL ? code : 0xFFFFUL;
+		R.flags = reset ? FAULT_RESET : 0;
+		return R;
+	}
 	bool isReset()
 	{
 		return reset;
@@ -64,23 +110,141 @@ public:
 	~FaultCode(){}
 };
 
-// FIFO Queue class
-class Queue
+// Smallest power of 2 at least n
+constexpr int pow2AtLeast(const int n, const int p=1)
+{
+	return p>=n ? p : pow2AtLeast(n, 2*p);
+}
+
+class DtcStatsBase;
+class FreezeFramesBase;
+
+// Which entries a queue walk visits
+enum QueueView : uint8_t {allCodes, activeCodes, resetCodes};
+
+// Circular walk over queue storage, front to rear or rear to front.  Wraps with a
+// compare instead of a modulo per step and skips entries outside the view.
+// Ends after the queued entries, so an empty queue yields nothing.
+class QueueIter
+{
+private:
+	FaultCode *A_;
+	int 			i_;       // Storage index
+	int 			left_;    // Queued entries not yet passed, 0 at end
+	int 			maxSize_;
+	int 			step_;    // +1 forward, -1 reverse
+	QueueView view_;
+	bool wanted(void) const
+	{
+		return view_==allCodes || (view_==activeCodes) != A_[i_].reset;
+	}
+	void advance(void)
+	{
+		left_--;
+		i_ += step_;
+		if ( i_==maxSize_ ) i_ = 0;
+		else if ( i_<0 ) 		i_ = maxSize_-1;
+	}
+	void skip(void)
+	{
+		while ( left_>0 && !wanted() ) advance();
+	}
+public:
+	QueueIter(FaultCode *A, const int i, const int left, const int maxSize, const int step, const QueueView view)
+	: A_(A), i_(i), left_(left), maxSize_(maxSize), step_(step), view_(view)
+	{
+		skip();
+	}
+	FaultCode& operator*() const { return A_[i_]; }
+	FaultCode* operator->() const { return &A_[i_]; }
+	QueueIter& operator++()
+	{
+		advance();
+		skip();
+		return *this;
+	}
+	bool operator!=(const QueueIter &it) const { return left_!=it.left_; }
+	int index(void) const { return i_; }
+};
+
+// Range over a queue walk for range-based for
+class QueueRange
 {
 private:
+	QueueIter begin_;
+	QueueIter end_;
+public:
+	QueueRange(const QueueIter &b, const QueueIter &e) : begin_(b), end_(e) {}
+	QueueIter begin(void) const { return begin_; }
+	QueueIter end(void) const { return end_; }
+};
+
+// FIFO Queue class.  Storage belongs to the derived Queue<N>.
+// Unreset codes are also kept in an open addressed hash, index_, so newCode()
+// finds duplicates in constant time.  Codes 1..65534 are indexed.
+// Active (unreset) and inactive counts are kept exact on every enqueue, dequeue
+// and reset, so count queries do not scan.
+// NVM holds a snapshot followed by a journal of changes.  storeNVM appends only
+// the changes since the last store and rewrites the snapshot when the journal
+// fills.  Journal slot i is valid only if its seq is base+1+i, and base grows on
+// every snapshot, so leftovers of older journals are never replayed.  The
+// snapshot sits behind an NvmHeader whose CRC32 is checked by loadNVM.  A
+// snapshot rewrite puts only the slots marked dirty since the last one.
+class QueueBase
+{
+protected:
 	int 			front_;
 	int 			rear_;
 	int 			maxSize_;
 	int 			gmt_;
-	String 		name_;
+	const char *name_;
 	bool 			storing_;
 	FaultCode *A_;
 	int 			verbose_;
+	uint16_t 	*index_;      // Unreset codes, 0 empty, 0xFFFF deleted
+	int 			indexSize_;   // Power of 2, at least 2*maxSize_
+	int 			indexUsed_;
+	int 			indexTombs_;
+	int 			active_;      // Unreset entries
+	int 			inactive_;    // Reset entries
+	bool 			stale_;       // Raw load, recount and reindex before use
+	JournalRecord *pending_;  // Changes since last storeNVM
+	int 			journalSize_; // NVM journal slots, also pending_ capacity
+	int 			journalUsed_; // NVM journal slots holding this snapshot's changes
+	int 			pendingN_;
+	uint32_t 	base_;        // Snapshot sequence number
+	bool 			compact_;     // Snapshot must be rewritten
+	bool 			journaling_;  // Record changes; off while replaying
+	bool 			wipe_;        // NVM journal holds unknown data, zero it with the next snapshot
+	uint32_t 	*dirty_;      // Slot bits, set where RAM differs from the NVM snapshot
+	unsigned long nvmBytes_;  // EEPROM bytes written since boot
+	unsigned long nvmWrites_; // EEPROM puts since boot
+	DtcStatsBase *stats_;     // Told of every sighting by newCode, may be NULL
+	FreezeFramesBase *frames_;  // Told of every newly logged code, may be NULL
+	QueueBase(FaultCode *A, const int maxSize, uint16_t *index, const int indexSize, JournalRecord *pending,\
+		const int journalSize, uint32_t *dirtyBits, const int GMT, const char *name, const bool storing, const int verbose);
+	void clean(void);
+	void dirty(const int i, const bool all=false);
+	bool isDirty(const int i);
+	void indexClear(void);
+	void indexErase(const unsigned long cod);
+	bool indexFind(const unsigned long cod);
+	int  indexHome(const unsigned long cod);
+	void indexInsert(const unsigned long cod);
+	void indexRebuild(void);
+	void journal(const uint8_t op, const FaultCode x);
+	void refresh(void);
+	int  storeJournal(const int start);
+	int  snapshotSize(void);
+	int  storeSnapshot(const int start);
+	void wipeJournal(const int start);
+	void writeSnapshot(const int start, const bool empty);
 public:
-	Queue(void);
-	Queue(const int maxSize, const int GMT, const String name, const bool storing, const int verbose);
-	Queue(const int front, const int rear, const int maxSize, const int GMT, const String name, const bool storing, const int verbose);
 	int  clearNVM(int);
+	void attach(DtcStatsBase *stats);
+	void attach(FreezeFramesBase *frames);
+	QueueRange codes(const QueueView view=allCodes);
+	QueueRange codesReverse(const QueueView view=allCodes);
 	bool IsEmpty(void);
 	bool IsFull(void);
 	void Enqueue(const FaultCode x);
@@ -91,18 +255,49 @@ public:
 	void Print(void);
 	int  front(void);
 	int  numActive(void);
+	int  numInActive(void);
 	int  printActive(void);
-	int  printActive(String *str);
-	int  printInActive(String *str, const int num);
+	int  printActive(TextBuf *str);
+	int  printInActive(TextBuf *str, const int num);
 	int  rear(void);
+	int  size(void);
 	int  maxSize(void);
-	String name(void);
+	const char *name(void);
 	int  loadNVM(const int start);
-	int  loadRaw(const uint8_t i, const FaultCode x);
-	FaultCode  getRaw(const uint8_t i);
-	void newCode(const unsigned long tim, const unsigned long cod);
+	int  loadRaw(const int i, const FaultCode x);
+	FaultCode  getRaw(const int i);
+	bool newCode(const unsigned long tim, const unsigned long cod);
+	unsigned long nvmBytes(void);
+	unsigned long nvmWrites(void);
+	int  nvmSize(void);
 	int  resetAll(void);
 	int  storeNVM(const int start);
+#ifdef QUEUE_DEBUG
+	bool checkInvariants(const char *where);
+#endif
+};
+
+// Queue of N codes and J journal slots with inline storage, for static placement.
+// NVM footprint is known at compile time:  header, then the snapshot of front,
+// rear, maxSize, base and N FaultRecord, then J JournalRecord
+template <int N, int J=N/2>
+class Queue : public QueueBase
+{
+private:
+	FaultCode 		store_[N];
+	uint16_t 			codeIndex_[pow2AtLeast(2*N)];
+	JournalRecord changes_[J];
+	uint32_t 			dirtyBits_[(N+31)/32];
+public:
+	static constexpr int capacity = N;
+	static constexpr int nvmFootprint = sizeof(NvmHeader) + 3*sizeof(int) + sizeof(uint32_t) + N*sizeof(FaultRecord) +\
+		J*sizeof(JournalRecord);  // nvmSize() at compile time
+	Queue(const int GMT, const char *name, const bool storing, const int verbose)
+	: QueueBase(store_, N, codeIndex_, pow2AtLeast(2*N), changes_, J, dirtyBits_, GMT, name, storing, verbose)
+	{
+		static_assert(N>1, "Queue needs at least 2 entries");
+		static_assert(J>0, "Queue needs at least 1 journal slot");
+	}
 };
 
 #endif
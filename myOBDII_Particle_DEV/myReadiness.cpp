@@ -0,0 +1,134 @@
+#include "application.h"
+#include "myReadiness.h"
+
+// Monitor names by Monitor, spark then compression ignition for the C and D bits
+static const char *sparkNames[MONITORS] = {"misfire", "fuel", "components", "catalyst", "heated cat",\
+	"evap", "second air", "A/C", "O2 sensor", "O2 heater", "EGR"};
+static const char *dieselNames[MONITORS] = {"misfire", "fuel", "components", "NMHC cat", "NOx/SCR",\
+	"reserved", "boost", "reserved", "exhaust", "PM filter", "EGR/VVT"};
+
+// Set bits in a 16 bit mask
+static uint8_t bits(uint16_t m)
+{
+	uint8_t n = 0;
+	for ( ; m; m &= m-1 ) n++;
+	return n;
+}
+
+// class Readiness
+// constructors
+Readiness::Readiness(ReadinessEvent event)
+: event_(event)
+{
+	reset();
+}
+
+// functions
+// Returns supported monitors that are complete
+uint8_t Readiness::completed()
+{
+	return bits(complete_);
+}
+
+// Returns DTC count, byte A
+uint8_t Readiness::dtcs()
+{
+	return dtcs_;
+}
+
+// Summary for a 10 character display line, e.g. "* 8/11 inc", * for MIL on
+void Readiness::format(TextBuf *str)
+{
+	if ( !valid_ )
+	{
+		str->add("----------");
+		return;
+	}
+	str->add(mil_ ? '*' : ' ').addUns(completed(), 2).add('/').addUns(supported()).add(ready() ? " RDY" : " inc");
+}
+
+// True if monitor mon is supported and complete
+bool Readiness::isComplete(const uint8_t mon)
+{
+	return mon<MONITORS && (complete_ & (1<<mon));
+}
+
+// True if the vehicle has monitor mon
+bool Readiness::isSupported(const uint8_t mon)
+{
+	return mon<MONITORS && (supported_ & (1<<mon));
+}
+
+// Returns MIL state, byte A bit 7
+bool Readiness::mil()
+{
+	return mil_;
+}
+
+// Monitor name for the engine type last seen
+const char *Readiness::name(const uint8_t mon)
+{
+	if ( mon>=MONITORS ) return "MIL";
+	return diesel_ ? dieselNames[mon] : sparkNames[mon];
+}
+
+// True when every supported monitor is complete, e.g. ready for inspection
+bool Readiness::ready()
+{
+	return valid_ && complete_==supported_;
+}
+
+// Forget the last decode
+void Readiness::reset()
+{
+	supported_ 	= 0;
+	complete_ 	= 0;
+	dtcs_ 			= 0;
+	mil_ 				= false;
+	diesel_ 		= false;
+	valid_ 			= false;
+}
+
+// Returns monitors supported
+uint8_t Readiness::supported()
+{
+	return bits(supported_);
+}
+
+// Decode data bytes A B C D.  Calls the event for every monitor that changed,
+// and with MON_MIL if the MIL or DTC count changed.  Returns the changed
+// monitor bits, bit MON_MIL included.  The first decode reports everything.
+// A reply shorter than 4 bytes is ignored, state and events untouched
+uint16_t Readiness::update(const ByteSpan A)
+{
+	if ( A.len<4 ) return 0;
+	uint8_t b = A[1];
+	uint8_t c = A[2];
+	uint8_t d = A[3];
+	uint16_t sup = (b & 0x07) | ((uint16_t)c<<3);
+	uint16_t inc = ((b>>4) & 0x07) | ((uint16_t)d<<3);
+	uint16_t com = sup & ~inc;
+	bool mil 		 = A[0] & 0x80;
+	uint8_t dtcs = A[0] & 0x7F;
+	uint16_t changed = (sup ^ supported_) | (com ^ complete_);
+	if ( !valid_ ) changed = sup | (1<<MON_MIL);
+	if ( mil!=mil_ || dtcs!=dtcs_ ) changed |= 1<<MON_MIL;
+	supported_ 	= sup;
+	complete_ 	= com;
+	mil_ 				= mil;
+	dtcs_ 			= dtcs;
+	diesel_ 		= b & 0x08;
+	valid_ 			= true;
+	if ( event_ )
+	{
+		for ( uint8_t m=0; m<=MON_MIL; m++ )
+			if ( changed & (1<<m) ) event_(m, m==MON_MIL || isSupported(m), m==MON_MIL ? !mil_ : isComplete(m));
+	}
+	return changed;
+}
+
+// True once decoded
+bool Readiness::valid()
+{
+	return valid_;
+}
@@ -0,0 +1,60 @@
+#ifndef _myReadiness_h
+#define _myReadiness_h
+
+#include <stdint.h>
+#include "myFormat.h"
+#include "myResponse.h"
+
+/* PID 0101 data bytes A B C D
+                       Test enabled	Test incomplete
+MIL on, DTC count      A7, A0-A6
+Compression ignition   B3
+Components	           B2	           B6
+Fuel System	           B1	           B5
+Misfire	               B0	           B4
+EGR System	           C7	           D7
+Oxygen Sensor Heater	 C6	           D6
+Oxygen Sensor	         C5	           D5
+A/C Refrigerant	       C4	           D4
+Secondary Air System	 C3	           D3
+Evaporative System	   C2	           D2
+Heated Catalyst	       C1	           D1
+Catalyst	             C0	           D0
+Compression ignition engines reuse the C and D bits for their own monitors.
+*/
+enum Monitor : uint8_t {monMisfire, monFuel, monComponents, monCatalyst, monHeatedCat, monEvap, monSecondaryAir,\
+	monAC, monO2, monO2Heater, monEGR, MONITORS};
+#define MON_MIL 	MONITORS    // Event for a change of MIL or DTC count
+
+// Called once per monitor whose state changed, or with MON_MIL
+typedef void (*ReadinessEvent)(const uint8_t mon, const bool supported, const bool complete);
+
+// Decoded readiness.  Monitors are bits of two masks, so a whole update is a
+// few mask operations and the inspection check is one compare.
+class Readiness
+{
+private:
+	uint16_t 				supported_;   // Bit per Monitor
+	uint16_t 				complete_;    // Supported and done
+	uint8_t 				dtcs_;
+	bool 						mil_;
+	bool 						diesel_;
+	bool 						valid_;       // Any update since reset
+	ReadinessEvent 	event_;
+public:
+	Readiness(ReadinessEvent event);
+	uint8_t  completed(void);
+	uint8_t  dtcs(void);
+	void format(TextBuf *str);
+	bool isComplete(const uint8_t mon);
+	bool isSupported(const uint8_t mon);
+	bool mil(void);
+	const char *name(const uint8_t mon);
+	bool ready(void);
+	void reset(void);
+	uint8_t  supported(void);
+	uint16_t update(const ByteSpan A);
+	bool valid(void);
+};
+
+#endif
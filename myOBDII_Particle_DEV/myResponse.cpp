@@ -0,0 +1,112 @@
+#include "application.h"
+#include "myResponse.h"
+
+// Adapter messages by their compacted text.  Anything else that is not hex is an error
+static const struct
+{
+	const char 	*text;
+	LineKind 		kind;
+} keywords[] = {
+	{"SEARCHING", lineSearching},
+	{"NODATA", 		lineNoData},
+	{"BUSINIT", 	lineBusInit},
+	{"STOPPED", 	lineStopped},
+};
+
+// Value of one hex digit, or -1
+static inline int8_t hexVal(const char c)
+{
+	if ( c>='0' && c<='9' ) return c-'0';
+	uint8_t u = (uint8_t)((c|0x20)-'a');
+	return u<6 ? u+10 : -1;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+#define HEX_SWAR    // Word at a time below needs the first character in the low byte
+#endif
+
+#ifdef HEX_SWAR
+#define HEX_ONES 	0x0101010101010101ULL
+#define HEX_HIGH 	0x8080808080808080ULL
+
+// Decode 8 hex characters in one 64 bit word to 4 bytes.  Each character is
+// range checked with carry-free adds that set its high bit, so validation is
+// part of the same pass.  False, and out untouched, if any is not hex
+static inline bool hexWord(const char *s, uint8_t *out)
+{
+	uint64_t x;
+	memcpy(&x, s, 8);
+	uint64_t l 			= x | 0x20*HEX_ONES;                               // Fold case
+	uint64_t digit 	= (x + 0x50*HEX_ONES) & ~(x + 0x46*HEX_ONES);     // '0'..'9'
+	uint64_t alpha 	= (l + 0x1F*HEX_ONES) & ~(l + 0x19*HEX_ONES);     // 'a'..'f'
+	if ( ((digit|alpha) & ~x & HEX_HIGH)!=HEX_HIGH ) return false;
+	uint64_t nib 	= (x & 0x0F*HEX_ONES) + ((alpha & HEX_HIGH)>>7)*9;   // 'A' is 0x41
+	uint64_t v 		= ((nib<<4) | (nib>>8)) & 0x00FF00FF00FF00FFULL;    // Pairs in even bytes
+	v = (v | (v>>8))  & 0x0000FFFF0000FFFFULL;
+	v = (v | (v>>16)) & 0x00000000FFFFFFFFULL;
+	uint32_t w = (uint32_t)v;
+	memcpy(out, &w, 4);
+	return true;
+}
+#endif
+
+// Decode n hex characters, n even, into n/2 bytes.  Runs 16 characters a step
+// where the platform allows, then a pair at a time.  Returns bytes decoded
+// before the first pair that is not hex:  spaces, prompts and odd tails stop it
+uint16_t hexDecode(const char *hex, const uint16_t n, uint8_t *out)
+{
+	uint16_t i = 0;
+#ifdef HEX_SWAR
+	while ( i+16<=n && hexWord(hex+i, out+i/2) && hexWord(hex+i+8, out+i/2+4) ) i += 16;
+	while ( i+8<=n && hexWord(hex+i, out+i/2) ) i += 8;
+#endif
+	for ( ; i+2<=n; i+=2 )
+	{
+		int8_t hi = hexVal(hex[i]);
+		int8_t lo = hexVal(hex[i+1]);
+		if ( hi<0 || lo<0 ) break;
+		out[i/2] = (hi<<4) | lo;
+	}
+	return i/2;
+}
+
+// Printable kind
+const char *lineName(const LineKind kind)
+{
+	switch ( kind )
+	{
+		case lineData: 				return "data";
+		case linePrompt: 			return "prompt";
+		case lineSearching: 	return "SEARCHING";
+		case lineNoData: 			return "NO DATA";
+		case lineBusInit: 		return "BUS INIT";
+		case lineStopped: 		return "STOPPED";
+		default: 							return "error";
+	}
+}
+
+// Classify rx and decode its hex pairs into line in a single pass.  Only a line
+// that is all hex pairs is data; otherwise line->len is 0
+LineKind tokenize(const char *rx, ObdLine *line)
+{
+	uint16_t n = strlen(rx);
+	line->len = 0;
+	if ( n==0 ) return line->kind = linePrompt;
+	uint16_t m = n/2<OBD_BYTES ? n/2 : OBD_BYTES;
+	if ( (n&1)==0 && n/2==m && hexDecode(rx, n, line->bytes)==m )
+	{
+		line->len = m;
+		return line->kind = lineData;
+	}
+	line->kind = lineError;
+	for ( uint8_t i=0; i<sizeof(keywords)/sizeof(keywords[0]); i++ )
+	{
+		if ( strncmp(rx, keywords[i].text, strlen(keywords[i].text))==0 )
+		{
+			line->kind = keywords[i].kind;
+			break;
+		}
+	}
+	if ( line->kind==lineBusInit && strstr(rx, "ERROR") ) line->kind = lineError;  // BUS INIT: ...ERROR
+	return line->kind;
+}
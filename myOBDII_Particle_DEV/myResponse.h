@@ -0,0 +1,46 @@
+#ifndef _myResponse_h
+#define _myResponse_h
+
+#include <stdint.h>
+
+#define OBD_BYTES 	52    // Decoded bytes per line, getResponse keeps 100 characters
+
+// What a received line is.  getResponse has already stripped spaces and the
+// prompt, so "NO DATA" arrives as "NODATA" and a bare prompt as an empty line.
+enum LineKind : uint8_t {lineData, linePrompt, lineSearching, lineNoData, lineBusInit, lineStopped, lineError};
+
+// Read only view of decoded bytes.  Reads past the end return 0 so decoders
+// need not check the length of every optional byte.
+class ByteSpan
+{
+public:
+	const uint8_t *data;
+	uint8_t 			len;
+	ByteSpan(const uint8_t *d, const uint8_t n) : data(d), len(n) {}
+	uint8_t operator[](const uint8_t i) const { return i<len ? data[i] : 0; }
+	// Bytes from i on
+	ByteSpan from(const uint8_t i) const { return i<len ? ByteSpan(data+i, len-i) : ByteSpan(data, 0); }
+	// Big endian pair at i, e.g. (A*256)+B
+	uint16_t word(const uint8_t i) const { return ((uint16_t)(*this)[i]<<8) | (*this)[i+1]; }
+};
+
+// One received line, classified and converted once by tokenize().  Holds no
+// pointer into the receive buffer so it may be copied between threads.
+class ObdLine
+{
+public:
+	uint8_t 	bytes[OBD_BYTES];
+	uint8_t 	len;
+	LineKind 	kind;
+	ObdLine(void) : len(0), kind(linePrompt) {}
+	bool data(void) const { return kind==lineData; }
+	ByteSpan span(void) const { return ByteSpan(bytes, len); }
+	// Adapter status that precedes the real answer on the next line
+	bool status(void) const { return kind==lineSearching || kind==lineBusInit; }
+};
+
+uint16_t hexDecode(const char *hex, const uint16_t n, uint8_t *out);
+const char *lineName(const LineKind kind);
+LineKind tokenize(const char *rx, ObdLine *line);
+
+#endif
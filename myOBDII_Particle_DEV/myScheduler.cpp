@@ -0,0 +1,95 @@
+#include "application.h"
+#include "myScheduler.h"
+
+// class Scheduler
+// constructors
+Scheduler::Scheduler(const int verbose)
+: num_(0), verbose_(verbose)
+{}
+
+// functions
+// Add a task first released first ms after start().  Returns task id, -1 if table full
+int Scheduler::add(const char *name, TaskRun run, const unsigned long period, const unsigned long deadline,\
+	const unsigned long budget, const unsigned long first)
+{
+	if ( num_>=MAX_TASKS || run==NULL || period==0UL ) return -1;
+	tasks_[num_] = Task(name, run, period, deadline, budget, first);
+	return num_++;
+}
+
+// Run the released task with the earliest deadline.  Returns its id, -1 if none due
+int Scheduler::dispatch(const unsigned long now)
+{
+	int next = -1;
+	for ( int i=0; i<num_; i++ )
+	{
+		Task *T = &tasks_[i];
+		if ( !T->enabled || (long)(now-T->release)<0 ) continue;
+		if ( next<0 || (long)(T->release+T->deadline - (tasks_[next].release+tasks_[next].deadline))<0 ) next = i;
+	}
+	if ( next<0 ) return -1;
+
+	Task *T = &tasks_[next];
+	unsigned long late = now - T->release;
+	T->run(now);
+	unsigned long done = millis();
+	unsigned long ran  = done - now;
+	T->runs++;
+	if ( late>T->maxLate ) T->maxLate = late;
+	if ( ran>T->maxRun ) 	 T->maxRun  = ran;
+	if ( ran>T->budget ) 	 T->overruns++;
+	if ( done-T->release>T->deadline )
+	{
+		T->misses++;
+		if ( verbose_>3 ) Serial.printf("%s missed deadline by %lu ms\n", T->name, done-T->release-T->deadline);
+	}
+
+	// Next release on the original grid; drop any wholly lost
+	T->release += T->period;
+	while ( (long)(done-T->release)>=(long)T->period )
+	{
+		T->release += T->period;
+		T->skips++;
+	}
+	return next;
+}
+
+// Enable or disable a task.  Enabling releases it now
+void Scheduler::enable(const int id, const bool enabled)
+{
+	if ( id<0 || id>=num_ ) return;
+	if ( enabled && !tasks_[id].enabled ) tasks_[id].release = millis();
+	tasks_[id].enabled = enabled;
+}
+
+// Print statistics table
+void Scheduler::Print()
+{
+	Serial.printf("task      runs  miss  over  skip  late  run ms\n");
+	for ( int i=0; i<num_; i++ )
+	{
+		Task *T = &tasks_[i];
+		Serial.printf("%-8s %5lu %5lu %5lu %5lu %5lu %5lu\n", T->name, T->runs, T->misses, T->overruns, T->skips,\
+			T->maxLate, T->maxRun);
+	}
+}
+
+// Clear statistics of all tasks
+void Scheduler::reset()
+{
+	for ( int i=0; i<num_; i++ ) tasks_[i].clear();
+}
+
+// Count first releases from now, e.g. the end of setup, so time spent
+// before dispatching begins is not charged to the tasks as lateness
+void Scheduler::start(const unsigned long now)
+{
+	for ( int i=0; i<num_; i++ ) tasks_[i].release += now;
+}
+
+// Task by id, for its statistics.  NULL if unknown
+const Task *Scheduler::task(const int id)
+{
+	if ( id<0 || id>=num_ ) return NULL;
+	return &tasks_[id];
+}
@@ -0,0 +1,86 @@
+#ifndef _myScheduler_h
+#define _myScheduler_h
+
+#include <stdint.h>
+
+#define MAX_TASKS 8   // Task table size
+
+// One pass of a periodic task.  now is its dispatch time, ms
+typedef void (*TaskRun)(const unsigned long now);
+
+// Periodic task with its timing and statistics.  Releases are every period
+// from the first, so a slow pass does not shift later ones
+class Task
+{
+public:
+	const char		*name;
+	TaskRun 			run;
+	unsigned long period;       // Between releases, ms
+	unsigned long deadline;     // Allowed from release to finish, ms
+	unsigned long budget;       // Allowed run time, ms
+	unsigned long release;      // Next release time, ms
+	bool 					enabled;
+	unsigned long runs;
+	unsigned long misses;       // Finished after deadline
+	unsigned long overruns;     // Ran longer than budget
+	unsigned long skips;        // Releases dropped because a whole period was lost
+	unsigned long maxLate;      // Worst release to start, ms
+	unsigned long maxRun;       // Worst run time, ms
+	Task(void)
+	{
+		name 			= "";
+		run 			= NULL;
+		period 		= 0UL;
+		deadline 	= 0UL;
+		budget 		= 0UL;
+		release 	= 0UL;
+		enabled 	= false;
+		clear();
+	}
+	Task(const char *nam, TaskRun ru, const unsigned long per, const unsigned long dead, const unsigned long bud,\
+		const unsigned long first)
+	{
+		name 			= nam;
+		run 			= ru;
+		period 		= per;
+		deadline 	= dead;
+		budget 		= bud;
+		release 	= first;
+		enabled 	= true;
+		clear();
+	}
+	void clear(void)
+	{
+		runs 			= 0UL;
+		misses 		= 0UL;
+		overruns 	= 0UL;
+		skips 		= 0UL;
+		maxLate 	= 0UL;
+		maxRun 		= 0UL;
+	}
+	~Task(){}
+};
+
+// Cooperative earliest-deadline-first dispatcher for loop().  Each dispatch()
+// runs at most one released task, the one whose deadline comes first, and
+// records how late it started, whether it finished in time and within budget.
+// First releases given to add() count from start(), not from boot.
+class Scheduler
+{
+private:
+	Task 		tasks_[MAX_TASKS];
+	uint8_t num_;
+	int 		verbose_;
+public:
+	Scheduler(const int verbose);
+	int  add(const char *name, TaskRun run, const unsigned long period, const unsigned long deadline,\
+		const unsigned long budget, const unsigned long first);
+	int  dispatch(const unsigned long now);
+	void enable(const int id, const bool enabled);
+	void Print(void);
+	void reset(void);
+	void start(const unsigned long now);
+	const Task *task(const int id);
+};
+
+#endif
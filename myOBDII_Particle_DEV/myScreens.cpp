@@ -0,0 +1,85 @@
+#include "application.h"
+#include "myScreens.h"
+
+// class Compositor
+// constructors
+Compositor::Compositor(MicroOLED *oled, const int verbose)
+: oled_(oled), num_(0), current_(0), shownAt_(0UL), dirty_(true), started_(false), verbose_(verbose)
+{}
+
+// functions
+// Append a screen to the rotation.  Returns its id, -1 if table full
+int Compositor::add(const char *name, ScreenRender render, const unsigned long dwell)
+{
+	if ( num_>=MAX_SCREENS )
+	{
+		if ( verbose_>0 ) Serial.printf("Compositor:  no room for %s\n", name);
+		return -1;
+	}
+	screens_[num_] = Screen(name, render, dwell);
+	return num_++;
+}
+
+// Returns id of screen on show
+int Compositor::current()
+{
+	return current_;
+}
+
+// Put the current screen into the page buffer and push it to the OLED
+void Compositor::draw(const unsigned long now)
+{
+	(void)now;
+	if ( verbose_>4 ) Serial.printf("Compositor:  drawing %s\n", screens_[current_].name);
+	oled_->clear(PAGE);
+	screens_[current_].render(oled_);
+	oled_->display();
+	dirty_ = false;
+}
+
+// Include or skip a screen in the rotation
+void Compositor::enable(const int id, const bool enabled)
+{
+	if ( id<0 || id>=num_ ) return;
+	screens_[id].enabled = enabled;
+	if ( id==current_ ) dirty_ = true;
+}
+
+// Mark screen content stale.  Redrawn on next tick only if on show
+void Compositor::invalidate(const int id)
+{
+	if ( id==current_ ) dirty_ = true;
+}
+
+// Jump to a screen now, restarting its dwell
+void Compositor::show(const int id, const unsigned long now)
+{
+	if ( id<0 || id>=num_ ) return;
+	current_ 	= id;
+	shownAt_ 	= now;
+	started_ 	= true;
+	draw(now);
+}
+
+// Advance the rotation when dwell expires and redraw stale content.  Returns true if drawn
+bool Compositor::tick(const unsigned long now)
+{
+	if ( num_==0 ) return false;
+	if ( !started_ || (now-shownAt_)>=screens_[current_].dwell )
+	{
+		uint8_t next = current_;
+		for ( uint8_t i=0; i<num_; i++ )
+		{
+			next = (next+1)%num_;
+			if ( screens_[next].enabled ) break;
+		}
+		if ( !started_ ) next = current_;
+		if ( next!=current_ || !started_ ) dirty_ = true;
+		current_ 	= next;
+		shownAt_ 	= now;
+		started_ 	= true;
+	}
+	if ( !dirty_ ) return false;
+	draw(now);
+	return true;
+}
@@ -0,0 +1,64 @@
+#ifndef _myScreens_h
+#define _myScreens_h
+
+#include "SparkFunMicroOLED.h"
+
+// Usually defined.  Comment out to restore the blocking display holds, e.g. to
+// compare bus utilization with and without the compositor.
+#define COMPOSITOR
+
+#define MAX_SCREENS 6   // Screen table size
+
+// Draws one whole screen into the OLED page buffer
+typedef void (*ScreenRender)(MicroOLED* oled);
+
+class Screen
+{
+public:
+	const char		*name;
+	ScreenRender 	render;
+	unsigned long dwell;        // Time on show before switching, ms
+	bool 					enabled;
+	Screen(void)
+	{
+		name 		= "";
+		render 	= NULL;
+		dwell 	= 0UL;
+		enabled = false;
+	}
+	Screen(const char *nam, ScreenRender ren, const unsigned long dwel)
+	{
+		name 		= nam;
+		render 	= ren;
+		dwell 	= dwel;
+		enabled = true;
+	}
+	~Screen(){}
+};
+
+// Round-robin screen manager.  Never blocks:  tick() draws at most one screen
+// and returns, so the UART keeps being polled while a screen is on show.
+class Compositor
+{
+private:
+	MicroOLED 		*oled_;
+	Screen 				screens_[MAX_SCREENS];
+	uint8_t 			num_;
+	uint8_t 			current_;
+	unsigned long shownAt_;       // Time current screen went up, ms
+	bool 					dirty_;         // Current screen needs redraw
+	bool 					started_;
+	int 					verbose_;
+public:
+	Compositor(MicroOLED *oled, const int verbose);
+	int  add(const char *name, ScreenRender render, const unsigned long dwell);
+	int  current(void);
+	void enable(const int id, const bool enabled);
+	void invalidate(const int id);
+	void show(const int id, const unsigned long now);
+	bool tick(const unsigned long now);
+private:
+	void draw(const unsigned long now);
+};
+
+#endif
@@ -1,74 +1,65 @@
 #include "application.h"
+#include <atomic>
 #include "myQueue.h"
 #include "mySubs.h"
+#include "myEcu.h"
+#include "myScreens.h"
 
-extern char       rxIndex;
+extern std::atomic<unsigned long> busMicros;
+extern uint8_t    rxIndex;
 extern int        verbose;
+Print            *ioLog = &Serial;  // Adapter traffic log, the I/O thread's LogPipe once started
 
-// Simple OLED print
-void  display(MicroOLED* oled, const uint8_t x, const uint8_t y, const String str,\
-   const int hold, const ClearType clear, const FontType type, const uint8_t clearA)
+// Adapter silent:  say so, then give it up to NOCONN_WAIT ms to come back.  Only
+// Serial1 is watched and the text goes through ioLog, so on the I/O thread
+// the console is not touched.  oled is NULL there
+static void noConnection(MicroOLED* oled)
 {
-  Serial.println(str);
-  if (clearA) oled->clear(ALL);
-  if (clear) oled->clear(PAGE);
-  oled->setFontType(type);
-  oled->setCursor(x, y*oled->getFontHeight());
-  oled->print(str);
-  oled->display();
+  if ( oled ) display(oled, 0, 0, "No conn>", 0, page, font8x16);
+  else ioLog->printf("No conn>\n");
+  unsigned long t0 = millis();
+  while ( !Serial1.available() && millis()-t0<NOCONN_WAIT ) delay(10);
+}
+
+// Legacy blocking hold.  The compositor shows screens for their dwell instead
+static void holdDisplay(const int hold)
+{
+#ifndef COMPOSITOR
   delay(hold);
+#else
+  (void)hold;
+#endif
 }
 
 // Simple OLED print
-void  displayStr(MicroOLED* oled, const uint8_t x, const uint8_t y, const String str, \
-  const int hold, const ClearType clear, const FontType type, const uint8_t clearA)
+void  display(MicroOLED* oled, const uint8_t x, const uint8_t y, const char *str,\
+   const int hold, const ClearType clear, const FontType type, const uint8_t clearA)
 {
-  Serial.print(str);
+  Serial.println(str);
   if (clearA) oled->clear(ALL);
   if (clear) oled->clear(PAGE);
   oled->setFontType(type);
   oled->setCursor(x, y*oled->getFontHeight());
   oled->print(str);
   oled->display();
-  delay(hold);
+  holdDisplay(hold);
 }
 
-// Get and display engine codes
-void  getCodes(MicroOLED* oled, const String cmd, unsigned long faultTime, char* rxData, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], Queue *F)
+// Log the engine codes in a mode 03 or 07 response.  Returns number found
+int   takeCodes(unsigned long faultTime, const ByteSpan resp, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], QueueBase *F)
 {
   if ( faultTime<1454540170 || faultTime>1770159369 )  // Validation;  time on 03-Feb-2016 and 03-Feb-2026
   {
-    Serial.printf("getCodes:  bad time = %u\n", faultTime);
-    return;
+    Serial.printf("takeCodes:  bad time = %u\n", faultTime);
+    return 0;
   }
-  if ( ping(oled, cmd, rxData) == 0 ) // success
-  {
-    int nActive = parseCodes(rxData, codes, ncodes);
-    for ( int i=0; i<nActive; i++ )
-    {
-      F->newCode(faultTime, codes[i]);
-      activeCode[i] = codes[i];
-      //displayStr(oled, 0, 1, "getCodes:" + String(activeCode[i]));
-      if ( i<nActive-1 ) displayStr(oled, 0, 2, ",");
-      delay(1000);
-    }
-    display(oled, 0, 1, "");
-    delay(1000);
-  }
-}
-
-// Get and display jumper codes
-void  getJumpFaultCodes(MicroOLED* oled, const String cmd, const String val, unsigned long faultTime, char* rxData, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], const bool ignoring, Queue *F)
-{
-  pingJump(oled, cmd, val, rxData);
-  int nActive = parseCodes(rxData, codes, ncodes);
-  for ( int i=0; (i<nActive&&!ignoring); i++ )
+  int nActive = parseCodes(resp, codes, ncodes);
+  for ( int i=0; i<nActive; i++ )
   {
     F->newCode(faultTime, codes[i]);
-    if ( verbose>2 )  F->Print();
-    delay(1000);
+    activeCode[i] = codes[i];
   }
-  display(oled, 0, 2, "");
+  return nActive;
 }
 
 //The getResponse function collects incoming data from the UART into the rxData buffer
@@ -77,10 +68,11 @@ void  getJumpFaultCodes(MicroOLED* oled, const String cmd, const String val, uns
 // and the rxData index is reset to 0 so that the next string can be copied.
 int   getResponse(MicroOLED* oled, char* rxData)
 {
+  (void)oled;
   char inChar=0;
   if ( verbose>4 )
   {
-    Serial.printf("Rx:");
+    ioLog->printf("Rx:");
   }
   else delay(150);
   //Keep reading characters until we get a carriage return
@@ -95,7 +87,7 @@ int   getResponse(MicroOLED* oled, char* rxData)
         rxData[rxIndex]='\0';
         rxIndex = 0;                // Reset the buffer for next pass
         if ( verbose>4 ){
-          Serial.printf(";\n");
+          ioLog->printf(";\n");
         }
         else delay(150);
         notFound = false;
@@ -108,9 +100,9 @@ int   getResponse(MicroOLED* oled, char* rxData)
         else if (inChar == '\0')  continue;   // Strip delimiters
         else rxData[rxIndex++] = inChar;
         if ( verbose>4 ){
-          if ( verbose>5 ) Serial.printf("[");
-          Serial.printf("%c", inChar);
-          if ( verbose>5 ) Serial.printf("]");
+          if ( verbose>5 ) ioLog->printf("[");
+          ioLog->printf("%c", inChar);
+          if ( verbose>5 ) ioLog->printf("]");
         }
         else delay(150);
       }
@@ -118,7 +110,7 @@ int   getResponse(MicroOLED* oled, char* rxData)
     else{   // !available
       if ( verbose>5 )
       {
-        Serial.printf(".");
+        ioLog->printf(".");
       }
       else delay(150);
     }
@@ -126,47 +118,34 @@ int   getResponse(MicroOLED* oled, char* rxData)
   return (notFound);
 }
 
-// Parse the OBD-II long string of codes returned by UART.
-int   parseCodes(const char *rxData, unsigned long *codes, uint8_t *ncodes)
+// Parse a mode 03 or 07 response:  count byte then two bytes per code.  The
+// digits are read as decimal, as printed, so P0133 is logged as 133
+int   parseCodes(const ByteSpan resp, unsigned long *codes, uint8_t *ncodes)
 {
-    int n = strlen(rxData);
-    if ( verbose>4 ) Serial.printf("rxData[%d]=%s\n", n, rxData);
-    if ( n < 8 )
-    {
-      *ncodes = 0;
-      return(0);
-    }
-    char numC[3];
-    numC[0] = rxData[2];
-    numC[1] = rxData[3];
-    numC[2] = '\0';
-    *ncodes = strtol(numC, NULL, 10);
-    if ( *ncodes*4>(n-4) || *ncodes>100 )
+    *ncodes = 0;
+    if ( verbose>4 ) Serial.printf("parseCodes: %d bytes\n", resp.len);
+    if ( resp.len < 4 ) return(0);
+    uint8_t count = (resp[1]>>4)*10 + (resp[1]&0x0F);
+    if ( count*2>(resp.len-2) || count>100 ) return(0);
+    if ( verbose>4 ) Serial.printf("parseCodes: codes[%d]=", count);
+    for ( uint8_t k=0; k<count; k++ )
     {
-      *ncodes = 0;
-      return(0);
-    }
-    int i = 0;
-    int j = 4;
-    char C[5];
-    if ( verbose>4 ) Serial.printf("parseCodes: codes[%d]=", *ncodes);
-    while ( i < *ncodes )
-    {
-      C[0] = rxData[j++];
-      C[1] = rxData[j++];
-      C[2] = rxData[j++];
-      C[3] = rxData[j++];
-      C[4] = '\0';
-      unsigned long newCode = strtol(C, NULL, 10);
+      uint16_t w = resp.word(2+2*k);
+      unsigned long newCode = 0;
+      for ( int8_t shift=12; shift>=0; shift-=4 )
+      {
+        uint8_t digit = (w>>shift) & 0x0F;
+        if ( digit>9 ) { newCode = 0; break; }   // Not a digit, rejected below
+        newCode = newCode*10 + digit;
+      }
       if ( newCode>0 && newCode<3500 )  // Validation
       {
-        codes[i++] = newCode;
-        if ( verbose>4 ) Serial.printf("%ld,", codes[i-1]);
+        codes[(*ncodes)++] = newCode;
+        if ( verbose>4 ) Serial.printf("%ld,", newCode);
       }
       else
       {
-        *ncodes--;
-        Serial.printf("[rejecting bad code %ld],", newCode);
+        Serial.printf("[rejecting bad code %04X],", w);
       }
     }
     if ( verbose>4 && *ncodes>0 ) Serial.printf("\n");
@@ -174,73 +153,97 @@ int   parseCodes(const char *rxData, unsigned long *codes, uint8_t *ncodes)
 }
 
 
+
 // Boilerplate driver
-int   ping(MicroOLED* oled, const String cmd, char* rxData)
+int   ping(MicroOLED* oled, const char *cmd, char* rxData, ObdLine *line, CanDemux *demux)
 {
+  ObdLine local;
+  if ( !line ) line = &local;
+  unsigned long t0 = micros();
   int notConnected = rxFlushToChar(oled, '>');
-  if (verbose>3) Serial.println("Tx:" + cmd);
+  if (verbose>3) ioLog->printf("Tx:%s\n", cmd);
   else delay(150);
-  Serial1.println(cmd + '\0');
+  Serial1.print(cmd);
+  Serial1.write(uint8_t('\0'));
+  Serial1.println();
   notConnected = rxFlushToChar(oled, '\r')  || notConnected;
-  notConnected = getResponse(oled, rxData)  || notConnected;
-  if (notConnected)
+  if ( demux && !notConnected )
+  { // ATH1:  a line per CAN frame from every ECU, then a blank line before the prompt
+    bool heard  = false;
+    bool can    = false;
+    demux->begin();
+    for ( int n=0; n<OBD_LINES; n++ )
+    {
+      if ( getResponse(oled, rxData) || rxData[0]=='\0' ) break;
+      heard = true;
+      if ( demux->frame(rxData) ) { can = true; continue; }
+      if ( tokenize(rxData, line)!=lineData && line->status() ) continue;  // SEARCHING...
+      break;  // Non-CAN data, NO DATA, STOPPED, ? and errors
+    }
+    notConnected = !heard;
+    uint8_t mode = 0;
+    hexDecode(cmd, 2, &mode);
+    if ( can ) { if ( !demux->primary(line) && line->data() ) line->kind = lineNoData; }  // Frames all incomplete
+    else if ( line->data() && !CanDemux::unwrap(line, 0x40|mode) ) line->kind = lineNoData;
+  }
+  else
   {
-    display(oled, 0, 0, "No conn>", 0, page, font8x16);
-    int count = 0;
-    while (!Serial.available() && count++<5) delay(1000);
-    //while (!Serial.read()); // Blocking read
+    notConnected = getResponse(oled, rxData)  || notConnected;
+    if ( !notConnected && tokenize(rxData, line)!=lineData && line->status() )
+    { // SEARCHING... or BUS INIT: ...OK, the answer follows
+      notConnected = getResponse(oled, rxData) || tokenize(rxData, line)!=lineData;
+    }
   }
-  else if ( strstr(rxData, "NODATA") ) notConnected = 1;
+  if ( verbose>4 ) ioLog->printf("ping:  %s, %d bytes\n", lineName(line->kind), line->len);
+  if (notConnected) noConnection(oled);
+  else if ( !line->data() ) notConnected = 1;  // NO DATA, STOPPED, ? and errors
+  busMicros += micros()-t0;
   return (notConnected);
 }
 
 // boilerplate jumper driver
-int   pingJump(MicroOLED* oled, const String cmd, const String val, char* rxData)
+int   pingJump(MicroOLED* oled, const char *cmd, const char *val, char* rxData, ObdLine *line)
 {
-  if (verbose>3) Serial.println("Tx:" + cmd);
+  unsigned long t0 = micros();
+  if (verbose>3) ioLog->printf("Tx:%s\n", cmd);
   delay(500);
   Serial1.println(cmd);
   delay(500);
   int notConnected = rxFlushToChar(oled, '\r');
   delay(500);
-  if (verbose>3) Serial.println("Tx:" + val);
+  if (verbose>3) ioLog->printf("Tx:%s\n", val);
   Serial1.println(val);
   delay(500);
   notConnected = getResponse(oled, rxData) || notConnected;
-  if (notConnected)
-  {
-    display(oled, 0, 0, "No conn>", 0, page, font8x16);
-    int count = 0;
-    while (!Serial.available() && count++<5) delay(1000);
-    //while (!Serial.read());   // Blocking read
-  }
+  if ( line ) tokenize(rxData, line);   // Jumper values are decimal, only codes decode
+  if (notConnected) noConnection(oled);
   delay(500);
+  busMicros += micros()-t0;
   return(notConnected);
 }
 
 // Boilerplate driver
-void  pingReset(MicroOLED* oled, const String cmd)
+void  pingReset(MicroOLED* oled, const char *cmd)
 {
+  unsigned long t0 = micros();
   int notConnected = rxFlushToChar(oled, '>');
-  if (notConnected)
-  {
-    display(oled, 0, 0, "No conn>", 0, page, font8x16);
-    int count = 0;
-    while (!Serial.available() && count++<5) delay(1000);
-    //while (!Serial.read());  // Blocking read
-  }
-  if (verbose>3) Serial.println("Tx:" + cmd);
-  Serial1.println(cmd + '\0');
+  if (notConnected) noConnection(oled);
+  if (verbose>3) ioLog->printf("Tx:%s\n", cmd);
+  Serial1.print(cmd);
+  Serial1.write(uint8_t('\0'));
+  Serial1.println();
+  busMicros += micros()-t0;
 }
 
 
 // Spin until pchar, 0 if found, 1 if fail
 int   rxFlushToChar(MicroOLED* oled, const char pchar)
 {
+  (void)oled;
   char inChar=0;
   if ( verbose>4 )
   {
-    Serial.printf("Rx:");
+    ioLog->printf("Rx:");
   }
   else delay(150);
   //Keep reading characters until we get a carriage return
@@ -254,7 +257,7 @@ int   rxFlushToChar(MicroOLED* oled, const char pchar)
         inChar  = Serial1.read();    // Clear buffer
         if ( verbose>4 )
         {
-          Serial.printf("%c;\n", inChar);
+          ioLog->printf("%c;\n", inChar);
         }
         else delay(150);
         notFound = false;
@@ -266,9 +269,9 @@ int   rxFlushToChar(MicroOLED* oled, const char pchar)
         else if (inChar == '\0')  continue;   // Strip delimiters
         else if ( verbose>4 )
         {
-          if ( verbose>5 ) Serial.printf("<");
-          Serial.printf("%c", inChar);
-          if ( verbose>5 ) Serial.printf(">");
+          if ( verbose>5 ) ioLog->printf("<");
+          ioLog->printf("%c", inChar);
+          if ( verbose>5 ) ioLog->printf(">");
         }
         else delay(150);
       }
@@ -277,7 +280,7 @@ int   rxFlushToChar(MicroOLED* oled, const char pchar)
     {   // !available
       if ( verbose>5 )
       {
-        Serial.printf(",");
+        ioLog->printf(",");
       }
       else delay(150);
     }
@@ -2,20 +2,23 @@
 #define _MYSUBS_H
 
 #include "SparkFunMicroOLED.h"  // Include MicroOLED library
+#include "myResponse.h"
+class CanDemux;
 enum ClearType  : uint8_t {notPage, page};
 enum FontType   : uint8_t {font5x7, font8x16, sevensegment, fontlargenumber, space01, space02, space03};
 
-void  display(MicroOLED* oled, const uint8_t x, const uint8_t y, const String str, \
-  const int hold=0, const ClearType clear=notPage, const FontType type=font5x7, const uint8_t clearA=0);
-void  displayStr(MicroOLED* oled, const uint8_t x, const uint8_t y, const String str,\
+#define NOCONN_WAIT 	1000  // ms a silent adapter is given to come back, ping and friends
+
+extern Print     *ioLog;  // Where getResponse, ping and friends log
+
+void  display(MicroOLED* oled, const uint8_t x, const uint8_t y, const char *str, \
   const int hold=0, const ClearType clear=notPage, const FontType type=font5x7, const uint8_t clearA=0);
-void  getCodes(MicroOLED* oled, const String cmd, unsigned long faultTime, char* rxData, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], Queue *F);
-void  getJumpFaultCodes(MicroOLED* oled, const String cmd, const String val, unsigned long faultTime, char* rxData, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], const bool ignoring, Queue *F);
 int   getResponse(MicroOLED* oled, char* rxData);
-int   parseCodes(const char *rxData, unsigned long *codes, uint8_t *ncodes);
-int   ping(MicroOLED* oled, const String cmd, char* rxData);
-int   pingJump(MicroOLED* oled, const String cmd, const String val, char* rxData);
-void  pingReset(MicroOLED* oled, const String cmd);
+int   parseCodes(const ByteSpan resp, unsigned long *codes, uint8_t *ncodes);
+int   ping(MicroOLED* oled, const char *cmd, char* rxData, ObdLine *line=NULL, CanDemux *demux=NULL);
+int   pingJump(MicroOLED* oled, const char *cmd, const char *val, char* rxData, ObdLine *line=NULL);
+void  pingReset(MicroOLED* oled, const char *cmd);
+int   takeCodes(unsigned long faultTime, const ByteSpan resp, uint8_t *ncodes, unsigned long codes[100], unsigned long activeCode[100], QueueBase *F);
 int   rxFlushToChar(MicroOLED* oled, const char pchar);
 
 #endif
@@ -0,0 +1,254 @@
+#include "application.h"
+#include "myTsLog.h"
+
+// Append v as a little endian base 128 varint.  Returns bytes
+static uint8_t putVarint(uint8_t *p, uint32_t v)
+{
+	uint8_t n = 0;
+	while ( v>=0x80 )
+	{
+		p[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (uint8_t)v;
+	return n;
+}
+
+// Read a varint at *p and advance it
+static uint32_t getVarint(const uint8_t **p)
+{
+	uint32_t v = 0;
+	uint8_t shift = 0;
+	uint8_t b;
+	do
+	{
+		b = *(*p)++;
+		v |= (uint32_t)(b & 0x7F)<<shift;
+		shift += 7;
+	} while ( (b & 0x80) && shift<35 );
+	return v;
+}
+
+// Signed to unsigned so small deltas of either sign stay small
+static inline uint32_t zigzag(const long d)
+{
+	return ((uint32_t)d<<1) ^ (uint32_t)(d>>31);
+}
+
+static inline long unzigzag(const uint32_t z)
+{
+	return (long)(z>>1) ^ -(long)(z & 1);
+}
+
+// class TsLogBase
+// constructors
+TsLogBase::TsLogBase(uint8_t *pages, long *last, const uint16_t pageSize, const uint8_t numPages, const uint8_t channels,\
+	const uint8_t nvmPages, const bool storing, const int verbose)
+: pages_(pages), last_(last), pageSize_(pageSize), numPages_(numPages), channels_(channels), nvmPages_(nvmPages),\
+	nvmSlot_(0), storing_(storing), verbose_(verbose)
+{
+	reset();
+}
+
+// functions
+// Log one row of channel values at time, s
+void TsLogBase::add(const uint32_t time, const long *values)
+{
+	uint8_t row[5 + 1 + 5*TSLOG_CHANNELS];
+	TsPage *h = (TsPage *)open();
+	bool first = h->rows==0;
+	uint8_t n = 0;
+	for ( int pass=0; pass<2; pass++ )
+	{
+		uint8_t mask = 0;
+		for ( uint8_t c=0; c<channels_; c++ )
+			if ( first || values[c]!=last_[c] ) mask |= 1<<c;
+		n = putVarint(row, first ? 0 : time-lastTime_);
+		row[n++] = mask;
+		for ( uint8_t c=0; c<channels_; c++ )
+			if ( mask & (1<<c) ) n += putVarint(row+n, zigzag(values[c] - (first ? 0 : last_[c])));
+		if ( h->used+n<=pageSize_ ) break;
+
+		// Seal the full page and start the next, recycling the oldest if needed.
+		// The tail is cleared so the page stores the same each time
+		memset(open()+h->used, 0, pageSize_-h->used);
+		sealed_++;
+		if ( nvmDue_<nvmPages_ ) nvmDue_++;
+		if ( count_==numPages_ )
+		{
+			lost_ += ((TsPage *)page(0))->rows;
+			head_ = head_+1==numPages_ ? 0 : head_+1;
+			count_--;
+		}
+		count_++;
+		h = (TsPage *)open();
+		h->rows = 0;
+		h->used = sizeof(TsPage);
+		first = true;
+	}
+	if ( first ) h->time = time;
+	memcpy(open()+h->used, row, n);
+	h->used += n;
+	h->rows++;
+	for ( uint8_t c=0; c<channels_; c++ ) last_[c] = values[c];
+	lastTime_ = time;
+	rows_++;
+	encoded_ += n;
+}
+
+// Returns bytes held, headers included
+unsigned long TsLogBase::bytes()
+{
+	unsigned long b = 0UL;
+	for ( uint8_t i=0; i<count_; i++ ) b += ((TsPage *)page(i))->used;
+	return b;
+}
+
+// Stream every row oldest first as CSV:  time then one column per channel
+void TsLogBase::dump(const char *header)
+{
+	Serial.printf("time,%s\n", header);
+	long v[TSLOG_CHANNELS];
+	for ( uint8_t i=0; i<count_; i++ )
+	{
+		const TsPage *h = (const TsPage *)page(i);
+		const uint8_t *p = page(i) + sizeof(TsPage);
+		uint32_t t = h->time;
+		for ( uint8_t c=0; c<channels_; c++ ) v[c] = 0L;
+		for ( uint16_t r=0; r<h->rows; r++ )
+		{
+			t += getVarint(&p);
+			uint8_t mask = *p++;
+			for ( uint8_t c=0; c<channels_; c++ )
+				if ( mask & (1<<c) ) v[c] += unzigzag(getVarint(&p));
+			Serial.printf("%lu", (unsigned long)t);
+			for ( uint8_t c=0; c<channels_; c++ ) Serial.printf(",%ld", v[c]);
+			Serial.printf("\n");
+		}
+	}
+}
+
+// Load the pages kept in NVM, oldest first.  Call at boot, before the first
+// add().  Slots not intact are skipped.  Returns the end of the region
+int TsLogBase::loadNVM(const int start)
+{
+	const int slotSize = sizeof(NvmHeader) + pageSize_;
+	uint8_t order[TSLOG_NVM_SLOTS];
+	uint32_t times[TSLOG_NVM_SLOTS];
+	uint8_t n = 0;
+	for ( uint8_t k=0; k<nvmPages_; k++ )
+	{
+		int at = start + k*slotSize;
+		TsPage h;
+		EEPROM.get(at+sizeof(NvmHeader), h);
+		if ( !checkNVM(at, NVM_TSLOG_MAGIC, NVM_TSLOG_VERSION, pageSize_) || h.used<sizeof(TsPage) || h.used>pageSize_ )
+			continue;
+		uint8_t i = n++;
+		for ( ; i>0 && times[i-1]>h.time; i-- )
+		{
+			order[i] = order[i-1];
+			times[i] = times[i-1];
+		}
+		order[i] = k;
+		times[i] = h.time;
+	}
+	reset();
+	if ( n==0 )
+	{
+		if ( nvmPages_>0 ) Serial.printf("Log NVM uninitialized, old format or corrupt...reinit...\n");
+		return start + nvmSize();
+	}
+	for ( uint8_t i=0; i<n; i++ )
+	{
+		uint8_t *p = page(i);
+		int at = start + order[i]*slotSize + sizeof(NvmHeader);
+		for ( uint16_t b=0; b<pageSize_; b++ ) p[b] = EEPROM.read(at+b);
+		restored_ += ((TsPage *)p)->rows;
+	}
+	count_ = n+1;
+	TsPage *h = (TsPage *)open();
+	h->time = 0UL;
+	h->rows = 0;
+	h->used = sizeof(TsPage);
+	nvmSlot_ = order[n-1]+1==nvmPages_ ? 0 : order[n-1]+1;
+	if ( verbose_>3 ) Serial.printf("log:  %u pages, %lu rows loaded from NVM\n", n, restored_);
+	return start + nvmSize();
+}
+
+// Returns NVM footprint, bytes
+int TsLogBase::nvmSize()
+{
+	return nvmPages_*(sizeof(NvmHeader) + pageSize_);
+}
+
+// Open page, last in the ring
+uint8_t *TsLogBase::open()
+{
+	return page(count_-1);
+}
+
+// Page i counted from the oldest
+uint8_t *TsLogBase::page(const uint8_t i)
+{
+	uint16_t at = head_ + i;
+	if ( at>=numPages_ ) at -= numPages_;
+	return pages_ + at*pageSize_;
+}
+
+// Compression and page use.  Amplification is page bytes sealed or open over
+// row bytes encoded:  headers plus the unused tail of each sealed page
+void TsLogBase::Print()
+{
+	unsigned long samples = rows_*channels_;
+	unsigned long written = sealed_*pageSize_ + ((TsPage *)open())->used;
+	Serial.printf("log:  %lu rows in %u of %u pages, %lu bytes, %lu rows recycled, %lu restored\n", rows(), count_, numPages_,\
+		bytes(), lost_, restored_);
+	if ( samples>0 && encoded_>0 )
+		Serial.printf("log:  %lu.%02lu bytes per sample (raw %u), write amplification %lu.%02lu\n",\
+			encoded_/samples, (encoded_%samples)*100/samples, (unsigned)sizeof(long),\
+			written/encoded_, (written%encoded_)*100/encoded_);
+}
+
+// Forget all rows
+void TsLogBase::reset()
+{
+	head_ 		= 0;
+	count_ 		= 1;
+	rows_ 		= 0UL;
+	encoded_ 	= 0UL;
+	sealed_ 	= 0UL;
+	lost_ 		= 0UL;
+	restored_ = 0UL;
+	nvmDue_ 	= 0;
+	lastTime_ = 0UL;
+	TsPage *h = (TsPage *)open();
+	h->time = 0UL;
+	h->rows = 0;
+	h->used = sizeof(TsPage);
+}
+
+// Returns rows still held
+unsigned long TsLogBase::rows()
+{
+	return rows_+restored_-lost_;
+}
+
+// Store the pages sealed since the last store, oldest first, each over the
+// oldest slot.  Nothing when none was sealed.  Returns the end of the region
+int TsLogBase::storeNVM(const int start)
+{
+	if ( !storing_ ) return start;
+	const int slotSize = sizeof(NvmHeader) + pageSize_;
+	uint8_t n = nvmDue_<count_-1 ? nvmDue_ : count_-1;
+	for ( uint8_t j=n; j>0; j-- )
+	{
+		const uint8_t *p = page(count_-1-j);
+		int at = start + nvmSlot_*slotSize;
+		for ( uint16_t b=0; b<pageSize_; b++ ) EEPROM.write(at+sizeof(NvmHeader)+b, p[b]);
+		sealNVM(at, NVM_TSLOG_MAGIC, NVM_TSLOG_VERSION, pageSize_, crc32(0UL, p, pageSize_));
+		nvmSlot_ = nvmSlot_+1==nvmPages_ ? 0 : nvmSlot_+1;
+	}
+	nvmDue_ = 0;
+	if ( verbose_>3 && n>0 ) Serial.printf("log:  %u pages stored\n", n);
+	return start + nvmSize();
+}
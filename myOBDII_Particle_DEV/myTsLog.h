@@ -0,0 +1,88 @@
+#ifndef _myTsLog_h
+#define _myTsLog_h
+
+#include <stdint.h>
+#include "myNvm.h"
+
+#define TSLOG_CHANNELS 	8     // Most channels a log may have, one mask bit each
+#define TSLOG_NVM_SLOTS 8     // Most pages a log may keep in NVM
+
+// NVM page format, bump version on any layout change
+#define NVM_TSLOG_MAGIC 	0x474F4C54UL  // "TLOG"
+#define NVM_TSLOG_VERSION 1
+
+// Page header.  Each page decodes on its own:  the first row is relative to zero
+struct __attribute__((packed)) TsPage
+{
+	uint32_t time;      // Time of first row, s
+	uint16_t rows;
+	uint16_t used;      // Bytes including this header
+};
+
+// Rolling time series log in page sized batches.  Storage belongs to the derived
+// TsLog<P, S, C, K>.  A row is
+//   varint seconds since previous row, change mask, zigzag varint delta of each
+//   changed channel
+// so a steady engine logs 2 bytes a row.  Rows fill the open page; a full page
+// is sealed and the oldest page is recycled once the ring is full.  The newest
+// K sealed pages are kept in NVM too, each a slot of header and page written
+// whole in turn.  storeNVM puts only pages sealed since the last store, so each
+// page is written once;  loadNVM puts them back ahead of the new rows.
+class TsLogBase
+{
+protected:
+	uint8_t 			*pages_;
+	long 					*last_;       // Values of previous row in open page
+	uint16_t 			pageSize_;
+	uint8_t 			numPages_;
+	uint8_t 			channels_;
+	uint8_t 			head_;        // Oldest page
+	uint8_t 			count_;       // Pages in use including the open one
+	uint32_t 			lastTime_;    // Time of previous row in open page, s
+	unsigned long rows_;        // Since reset
+	unsigned long encoded_;     // Row bytes since reset
+	unsigned long sealed_;      // Pages sealed since reset
+	unsigned long lost_;        // Rows recycled with their pages
+	unsigned long restored_;    // Rows loaded from NVM
+	uint8_t 			nvmPages_;    // Slots in NVM
+	uint8_t 			nvmSlot_;     // Next slot to write, the oldest
+	uint8_t 			nvmDue_;      // Sealed pages not yet stored, at most nvmPages_
+	bool 					storing_;
+	int 					verbose_;
+	TsLogBase(uint8_t *pages, long *last, const uint16_t pageSize, const uint8_t numPages, const uint8_t channels,\
+		const uint8_t nvmPages, const bool storing, const int verbose);
+	uint8_t *open(void);
+	uint8_t *page(const uint8_t i);
+public:
+	void add(const uint32_t time, const long *values);
+	unsigned long bytes(void);
+	void dump(const char *header);
+	int  loadNVM(const int start);
+	int  nvmSize(void);
+	void Print(void);
+	void reset(void);
+	unsigned long rows(void);
+	int  storeNVM(const int start);
+};
+
+// P pages of S bytes for C channels, inline storage, the newest K sealed pages
+// also in NVM
+template <int P, int S, int C, int K=0>
+class TsLog : public TsLogBase
+{
+private:
+	uint8_t store_[P*S];
+	long 		values_[C];
+public:
+	static constexpr int nvmFootprint = K*(sizeof(NvmHeader) + S);  // nvmSize() at compile time
+	TsLog(const bool storing, const int verbose)
+	: TsLogBase(store_, values_, S, P, C, K, storing, verbose)
+	{
+		static_assert(K>=0 && K<P && K<=TSLOG_NVM_SLOTS, "TsLog keeps 0 to P-1 pages in NVM, at most TSLOG_NVM_SLOTS");
+		static_assert(P>1 && P<256, "TsLog needs 2 to 255 pages");
+		static_assert(S>=64 && S<=4096, "TsLog page size 64 to 4096 bytes");
+		static_assert(C>0 && C<=TSLOG_CHANNELS, "TsLog channels 1 to TSLOG_CHANNELS");
+	}
+};
+
+#endif
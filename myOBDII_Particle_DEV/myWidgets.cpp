@@ -0,0 +1,258 @@
+#include "application.h"
+#include "myWidgets.h"
+
+// Bits of the page starting at row pageTop covered by rows a..b
+static uint8_t rowMask(const int a, const int b, const int pageTop)
+{
+	int lo = a-pageTop;
+	int hi = b-pageTop;
+	if ( hi<0 || lo>7 || b<a ) return 0;
+	if ( lo<0 ) lo = 0;
+	if ( hi>7 ) hi = 7;
+	return (uint8_t)((0xFF<<lo) & (0xFF>>(7-hi)));
+}
+
+// Light rows y0..y1 of column x and clear the rest of rows top..top+height-1.
+// Works a page byte at a time; y1<y0 clears the whole span.
+static void columnSpan(uint8_t *screen, const uint8_t x, const uint8_t top, const uint8_t height,\
+	const int y0, const int y1)
+{
+	if ( height==0 || x>=LCDWIDTH ) return;
+	uint8_t bottom = top+height-1;
+	if ( bottom>=LCDHEIGHT ) bottom = LCDHEIGHT-1;
+	for ( uint8_t page=top/8; page<=bottom/8; page++ )
+	{
+		uint8_t area = rowMask(top, bottom, page*8);
+		uint8_t ink  = rowMask(y0, y1, page*8);
+		uint8_t *b = screen + x + page*LCDWIDTH;
+		*b = (*b & ~area) | (ink & area);
+	}
+}
+
+
+// class BarGauge
+// constructors
+BarGauge::BarGauge(MicroOLED *oled, const uint8_t x, const uint8_t y, const uint8_t w, const uint8_t h, const long lo, const long hi)
+: oled_(oled), x_(x), y_(y), w_(w), h_(h), lo_(lo), hi_(hi), lastMicros_(0UL)
+{
+	reset();
+}
+
+// functions
+// Paint whole gauge into page buffer
+void BarGauge::draw()
+{
+	uint8_t *screen = oled_->getScreenBuffer();
+	for ( uint8_t i=0; i<w_; i++ ) columnSpan(screen, x_+i, y_, h_+2, 1, 0);
+	oled_->rect(x_, y_, w_, h_, WHITE, NORM);
+	for ( uint8_t i=0; i<w_-2; i++ )
+	{
+		if ( i<fill_ ) columnSpan(screen, x_+1+i, y_+1, h_-2, y_+1, y_+h_-2);
+	}
+	if ( seen_ )
+	{
+		marker(minAt_, true);
+		marker(maxAt_, true);
+	}
+}
+
+// Fold sample v into min_/max_.  Rescans the ring only when the sample that
+// dropped out of a full ring was an extreme
+void BarGauge::extremes(const long v, const long dropped, const bool full)
+{
+	if ( !seen_ ) { min_ = v; max_ = v; return; }
+	bool rescan = full && (dropped==min_ || dropped==max_);
+	if ( v<min_ ) min_ = v;
+	if ( v>max_ ) max_ = v;
+	if ( !rescan ) return;
+	min_ = ring_[0];
+	max_ = ring_[0];
+	for ( uint8_t i=1; i<count_; i++ )
+	{
+		if ( ring_[i]<min_ ) min_ = ring_[i];
+		if ( ring_[i]>max_ ) max_ = ring_[i];
+	}
+}
+
+// Returns cost of last visible update, us
+unsigned long BarGauge::lastMicros()
+{
+	return lastMicros_;
+}
+
+// Set or clear the 2 pixel tick below interior column at
+void BarGauge::marker(const uint8_t at, const bool on)
+{
+	if ( on ) columnSpan(oled_->getScreenBuffer(), x_+1+at, y_+h_, 2, y_+h_, y_+h_+1);
+	else 			columnSpan(oled_->getScreenBuffer(), x_+1+at, y_+h_, 2, 1, 0);
+}
+
+// Returns largest of the last GAUGE_SAMPLES values
+long BarGauge::max()
+{
+	return max_;
+}
+
+// Returns smallest of the last GAUGE_SAMPLES values
+long BarGauge::min()
+{
+	return min_;
+}
+
+// Forget fill, samples and extremes
+void BarGauge::reset()
+{
+	next_ 	= 0;
+	count_ 	= 0;
+	min_ 		= hi_;
+	max_ 		= lo_;
+	fill_ 	= 0;
+	minAt_ 	= 0;
+	maxAt_ 	= 0;
+	seen_ 	= false;
+}
+
+// Interior columns filled by v, clamped
+uint8_t BarGauge::scale(const long v)
+{
+	long c = v;
+	if ( c<lo_ ) c = lo_;
+	if ( c>hi_ ) c = hi_;
+	if ( hi_<=lo_ ) return 0;
+	return (uint8_t)((c-lo_)*(w_-2)/(hi_-lo_));
+}
+
+// New sample.  Repaints only the fill columns that changed and any moved marker
+void BarGauge::update(const long v, const bool visible)
+{
+	unsigned long t0 = micros();
+	uint8_t fill 	= scale(v);
+	bool full 		= count_==GAUGE_SAMPLES;
+	long dropped 	= ring_[next_];
+	ring_[next_] 	= v;
+	next_ 				= (next_+1)%GAUGE_SAMPLES;
+	if ( !full ) count_++;
+	extremes(v, dropped, full);
+	uint8_t minAt = scale(min_);
+	uint8_t maxAt = scale(max_);
+	if ( minAt>0 ) minAt--;  // Column at end of bar
+	if ( maxAt>0 ) maxAt--;
+	bool markersMoved = !seen_ || minAt!=minAt_ || maxAt!=maxAt_;
+	if ( !visible )
+	{
+		fill_ = fill; minAt_ = minAt; maxAt_ = maxAt; seen_ = true;
+		return;
+	}
+
+	// Dirty interior columns d0..d1
+	uint8_t *screen = oled_->getScreenBuffer();
+	uint8_t d0 = w_;
+	uint8_t d1 = 0;
+	uint8_t a = fill<fill_ ? fill : fill_;
+	uint8_t b = fill<fill_ ? fill_ : fill;
+	for ( uint8_t i=a; i<b; i++ )
+	{
+		if ( i<fill ) columnSpan(screen, x_+1+i, y_+1, h_-2, y_+1, y_+h_-2);
+		else 					columnSpan(screen, x_+1+i, y_+1, h_-2, 1, 0);
+	}
+	if ( b>a ) { d0 = a; d1 = b-1; }
+	if ( markersMoved )
+	{
+		if ( seen_ )
+		{
+			marker(minAt_, false);
+			marker(maxAt_, false);
+			if ( minAt_<d0 ) d0 = minAt_;
+			if ( maxAt_>d1 ) d1 = maxAt_;
+		}
+		marker(minAt, true);
+		marker(maxAt, true);
+		if ( minAt<d0 ) d0 = minAt;
+		if ( maxAt>d1 ) d1 = maxAt;
+	}
+	fill_ = fill; minAt_ = minAt; maxAt_ = maxAt; seen_ = true;
+	if ( d0<=d1 ) oled_->display(x_+1+d0, y_, d1-d0+1, h_+2);
+	lastMicros_ = micros()-t0;
+}
+
+
+// class Sparkline
+// constructors
+Sparkline::Sparkline(MicroOLED *oled, const uint8_t x, const uint8_t y, const uint8_t w, const uint8_t h, const long lo, const long hi)
+: oled_(oled), x_(x), y_(y), w_(w<=LCDWIDTH ? w : LCDWIDTH), h_(h), lo_(lo), hi_(hi), lastMicros_(0UL)
+{
+	reset();
+}
+
+// functions
+// Paint column i from the ring:  a segment joining the previous sample, or blank
+void Sparkline::column(const uint8_t i)
+{
+	uint8_t *screen = oled_->getScreenBuffer();
+	if ( i==cursor_ || i>=count_ )
+	{
+		columnSpan(screen, x_+i, y_, h_, 1, 0);
+		return;
+	}
+	uint8_t y0 = ring_[i];
+	uint8_t y1 = ring_[i];
+	if ( i>0 && (i-1)!=cursor_ )
+	{
+		if ( ring_[i-1]<y0 ) y0 = ring_[i-1];
+		if ( ring_[i-1]>y1 ) y1 = ring_[i-1];
+	}
+	columnSpan(screen, x_+i, y_, h_, y_+y0, y_+y1);
+}
+
+// Paint whole sparkline into page buffer
+void Sparkline::draw()
+{
+	for ( uint8_t i=0; i<w_; i++ ) column(i);
+}
+
+// Returns cost of last visible update, us
+unsigned long Sparkline::lastMicros()
+{
+	return lastMicros_;
+}
+
+// Forget history
+void Sparkline::reset()
+{
+	cursor_ = 0;
+	count_ 	= 0;
+}
+
+// Row offset from top for v, clamped
+uint8_t Sparkline::scale(const long v)
+{
+	long c = v;
+	if ( c<lo_ ) c = lo_;
+	if ( c>hi_ ) c = hi_;
+	if ( hi_<=lo_ ) return h_-1;
+	return (uint8_t)((hi_-c)*(h_-1)/(hi_-lo_));
+}
+
+// New sample.  Repaints only the written column, the gap ahead of it and the
+// column after the gap, which no longer joins the sample the gap replaced
+void Sparkline::update(const long v, const bool visible)
+{
+	unsigned long t0 = micros();
+	uint8_t written = cursor_;
+	ring_[written] = scale(v);
+	if ( count_<w_ ) count_++;
+	cursor_ = (cursor_+1)%w_;
+	if ( !visible ) return;
+	uint8_t after = (cursor_+1)%w_;
+	column(written);
+	column(cursor_);
+	column(after);
+	if ( after==written+2 ) oled_->display(x_+written, y_, 3, h_);
+	else
+	{
+		oled_->display(x_+written, y_, 1, h_);
+		oled_->display(x_+cursor_, y_, 1, h_);
+		oled_->display(x_+after, y_, 1, h_);
+	}
+	lastMicros_ = micros()-t0;
+}
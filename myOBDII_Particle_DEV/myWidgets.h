@@ -0,0 +1,64 @@
+#ifndef _myWidgets_h
+#define _myWidgets_h
+
+#include "SparkFunMicroOLED.h"
+
+#define GAUGE_SAMPLES 	64              // BarGauge min/max window, samples
+
+// Incremental widgets drawn straight into the MicroOLED page buffer.  draw()
+// paints the whole widget, e.g. when its screen comes up; update() repaints only
+// the columns that changed and transfers just that region.  When not visible,
+// update() only records the sample so the next draw() is current.
+
+// Horizontal bar gauge with min and max tick markers below the bar.  The markers
+// span the last GAUGE_SAMPLES samples, kept in a ring, so they follow the trend
+class BarGauge
+{
+private:
+	MicroOLED 		*oled_;
+	uint8_t 			x_, y_, w_, h_;   // Frame, px.  Markers take the 2 rows below
+	long 					lo_, hi_;         // Value at empty and full
+	long 					ring_[GAUGE_SAMPLES];  // Recent samples
+	uint8_t 			next_;            // Next ring slot to write
+	uint8_t 			count_;           // Valid samples
+	long 					min_, max_;       // Extremes over the ring
+	uint8_t 			fill_;            // Filled interior columns
+	uint8_t 			minAt_, maxAt_;   // Marker columns
+	bool 					seen_;            // Any sample since reset
+	unsigned long lastMicros_;      // Cost of last update, us
+	void extremes(const long v, const long dropped, const bool full);
+	uint8_t scale(const long v);
+	void marker(const uint8_t at, const bool on);
+public:
+	BarGauge(MicroOLED *oled, const uint8_t x, const uint8_t y, const uint8_t w, const uint8_t h, const long lo, const long hi);
+	void draw(void);
+	unsigned long lastMicros(void);
+	long max(void);
+	long min(void);
+	void reset(void);
+	void update(const long v, const bool visible);
+};
+
+// Sweeping sparkline.  A cursor walks left to right overwriting the oldest column,
+// so each sample changes only the cursor column and the blank gap ahead of it.
+class Sparkline
+{
+private:
+	MicroOLED 		*oled_;
+	uint8_t 			x_, y_, w_, h_;   // Area, px.  w_<=LCDWIDTH
+	long 					lo_, hi_;         // Value at bottom and top
+	uint8_t 			ring_[LCDWIDTH];  // Recent samples as row offsets from top
+	uint8_t 			cursor_;          // Next column to write
+	uint8_t 			count_;           // Valid columns
+	unsigned long lastMicros_;      // Cost of last update, us
+	uint8_t scale(const long v);
+	void column(const uint8_t i);
+public:
+	Sparkline(MicroOLED *oled, const uint8_t x, const uint8_t y, const uint8_t w, const uint8_t h, const long lo, const long hi);
+	void draw(void);
+	unsigned long lastMicros(void);
+	void reset(void);
+	void update(const long v, const bool visible);
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "application.h"
+#include "fake_elm.h"
+#include <new>
+
+// Runs the whole sketch, setup() then loop() against the scripted adapter, and
+// counts every heap allocation once it has settled.  Steady state must not
+// touch the heap:  the Photon heap fragments and is never compacted.  Then a
+// console command typed after a line end must still be seen.
+
+extern "C" void *__libc_malloc(size_t n);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t n);
+extern "C" void  __libc_free(void *p);
+
+static std::atomic<bool> 					counting(false);
+static std::atomic<unsigned long> allocs(0UL);
+
+extern "C" void *malloc(size_t n)
+{
+	if ( counting ) allocs++;
+	return __libc_malloc(n);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+	if ( counting ) allocs++;
+	return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t n)
+{
+	if ( counting ) allocs++;
+	return __libc_realloc(p, n);
+}
+
+extern "C" void free(void *p)
+{
+	__libc_free(p);
+}
+
+void *operator new(size_t n)
+{
+	if ( counting ) allocs++;
+	void *p = __libc_malloc(n ? n : 1);
+	if ( !p ) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t n) 				{ return operator new(n); }
+void  operator delete(void *p) noexcept 					{ __libc_free(p); }
+void  operator delete[](void *p) noexcept 				{ __libc_free(p); }
+void  operator delete(void *p, size_t) noexcept 	{ __libc_free(p); }
+void  operator delete[](void *p, size_t) noexcept { __libc_free(p); }
+
+void setup(void);
+void loop(void);
+
+// Run loop() for ms of simulated time in 10 ms steps.  Returns calls
+static unsigned long run(const unsigned long ms)
+{
+	unsigned long end = stubMillis+ms;
+	unsigned long calls = 0UL;
+	while ( stubMillis<end )
+	{
+		loop();
+		stubMillis += 10UL;
+		calls++;
+	}
+	return calls;
+}
+
+int main()
+{
+	fakeElmAttach();
+	setup();
+	run(300000UL);    // Every task has run and every screen has been drawn
+	unsigned long before = fakeElmRequests();
+	counting = true;
+	unsigned long calls = run(1800000UL);
+	counting = false;
+	printf("steady state:  %lu loop() calls, %lu adapter requests, %lu heap allocations\n",\
+		calls, fakeElmRequests()-before, allocs.load());
+
+	run(5000UL);      // Clear of taskDisplay, which prints the statistics too
+	Serial.feed("\r\ns");
+	Serial.out.clear();
+	Serial.capture = true;
+	run(100UL);
+	Serial.capture = false;
+	bool console = Serial.out.find("rpm      n ")!=std::string::npos && Serial.available()==0;
+	printf("console:  's' after a line end %s\n", console ? "prints the statistics" : "WRONG");
+	return allocs>0 || fakeElmRequests()==before || !console;
+}
@@ -0,0 +1,178 @@
+#ifndef _application_h
+#define _application_h
+
+// Host stand-in for the Particle firmware header, enough to build the DEV
+// sketch's modules on Linux.  Serial output can be captured, Serial1 replays
+// scripted adapter text, EEPROM is a RAM image that counts changed bytes and
+// millis() is a settable clock so schedulers can be simulated.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <string>
+#include <atomic>
+
+#define SYSTEM_THREAD(x) 		static const int _systemThread_##x = 0
+#define D6 									6
+#define D7 									7
+#define A2 									12
+#define SCK 								13
+#define MOSI 								15
+#define OUTPUT 							1
+#define INPUT_PULLUP 				2
+#define HIGH 								1
+#define LOW 								0
+#define SPI_CLOCK_DIV2 			2
+#define CLOCK_SPEED_400KHZ 	400000
+
+// Arduino String, only what the sketches still touch
+class String
+{
+public:
+	std::string s;
+	String(void) {}
+	String(const char *c) : s(c ? c : "") {}
+	String(const char c) : s(1, c) {}
+	String(const int v) : s(std::to_string(v)) {}
+	String(const unsigned v) : s(std::to_string(v)) {}
+	String(const long v) : s(std::to_string(v)) {}
+	String(const unsigned long v) : s(std::to_string(v)) {}
+	const char *c_str(void) const { return s.c_str(); }
+	unsigned length(void) const { return s.size(); }
+	String& operator+=(const String &o) { s += o.s; return *this; }
+	friend String operator+(const String &a, const String &b) { String r(a); r.s += b.s; return r; }
+	friend String operator+(const String &a, const char *b) { String r(a); r.s += b; return r; }
+	friend String operator+(const char *a, const String &b) { String r(a); r.s += b.s; return r; }
+};
+
+class Print
+{
+public:
+	virtual size_t write(uint8_t c) = 0;
+	size_t write(const char *s) { size_t n = 0; while ( *s ) n += write((uint8_t)*s++); return n; }
+	size_t write(const uint8_t *b, size_t len) { size_t n = 0; while ( len-- ) n += write(*b++); return n; }
+	size_t print(const char *s) { return write(s); }
+	size_t print(const String &s) { return write(s.c_str()); }
+	size_t print(const char c) { return write((uint8_t)c); }
+	size_t print(const int v) { return printf("%d", v); }
+	size_t print(const unsigned v) { return printf("%u", v); }
+	size_t print(const long v) { return printf("%ld", v); }
+	size_t print(const unsigned long v) { return printf("%lu", v); }
+	size_t println(void) { return write("\n"); }
+	size_t println(const char *s) { return print(s) + println(); }
+	size_t println(const String &s) { return print(s) + println(); }
+	size_t printf(const char *format, ...)
+	{
+		char b[256];
+		va_list a;
+		va_start(a, format);
+		vsnprintf(b, sizeof(b), format, a);
+		va_end(a);
+		return write(b);
+	}
+	virtual ~Print() {}
+};
+
+// USB Serial and the adapter UART.  Output goes to stdout unless capturing or
+// quiet.  Input is a fixed ring the harness fills with feed(), or an onLine
+// responder fills as each written line ends, as the adapter would.  Neither
+// touches the heap, so allocation counts stay clean
+class USARTSerial : public Print
+{
+private:
+	char 		rx_[4096];
+	size_t 	head_ = 0;
+	size_t 	tail_ = 0;
+	char 		line_[64];
+	uint8_t lineLen_ = 0;
+public:
+	std::string out;
+	bool 				capture = false;
+	bool 				quiet 	= true;
+	void (*onLine)(const char *line) = NULL;
+	void begin(int) {}
+	int  available(void) { return tail_-head_; }
+	int  peek(void) { return head_<tail_ ? (uint8_t)rx_[head_%sizeof(rx_)] : -1; }
+	int  read(void) { return head_<tail_ ? (uint8_t)rx_[head_++%sizeof(rx_)] : -1; }
+	void feed(const char *s) { while ( *s && tail_-head_<sizeof(rx_) ) rx_[tail_++%sizeof(rx_)] = *s++; }
+	virtual size_t write(uint8_t c)
+	{
+		if ( capture ) out += (char)c;
+		else if ( !quiet ) putchar(c);
+		if ( onLine )
+		{
+			if ( c=='\r' || c=='\n' )
+			{
+				line_[lineLen_] = '\0';
+				if ( lineLen_>0 ) onLine(line_);
+				lineLen_ = 0;
+			}
+			else if ( c!='\0' && lineLen_<sizeof(line_)-1 ) line_[lineLen_++] = c;
+		}
+		return 1;
+	}
+	using Print::write;
+};
+extern USARTSerial Serial, Serial1;
+
+// 2047 byte emulated EEPROM.  writes counts bytes that actually changed
+class EEPROMClass
+{
+public:
+	uint8_t 			mem[2047];
+	unsigned long writes = 0;
+	EEPROMClass(void) { memset(mem, 0xFF, sizeof(mem)); }
+	template <typename T> T& get(int p, T &t) { memcpy((void *)&t, mem+p, sizeof(T)); return t; }
+	template <typename T> const T& put(int p, const T &t)
+	{
+		const uint8_t *b = (const uint8_t *)&t;
+		for ( size_t i=0; i<sizeof(T); i++ ) write(p+i, b[i]);
+		return t;
+	}
+	uint8_t read(int p) { return mem[p]; }
+	void write(int p, uint8_t v) { if ( mem[p]!=v ) { mem[p] = v; writes++; } }
+	size_t length(void) { return sizeof(mem); }
+};
+extern EEPROMClass EEPROM;
+
+class TimeClass
+{
+public:
+	uint32_t now(void) { return 1500000000UL; }
+	void zone(float) {}
+	String format(uint32_t, const char *) { return String(""); }
+	int year(uint32_t) { return 2017; }
+	int month(uint32_t) { return 7; }
+	int day(uint32_t) { return 14; }
+	int hour(uint32_t) { return 2; }
+	int minute(uint32_t) { return 40; }
+};
+extern TimeClass Time;
+
+struct WiFiClass 		{ void disconnect(void) {} void off(void) {} };
+struct SystemClass 	{ uint32_t freeMemory(void) { return 0; } };
+extern WiFiClass 		WiFi;
+extern SystemClass 	System;
+
+// Simulated ms clock.  Advanced by delay(), from any thread, and by the harness
+extern std::atomic<unsigned long> stubMillis;
+unsigned long millis(void);
+unsigned long micros(void);   // Real host clock, for timing
+void delay(unsigned long ms);
+
+typedef void (*os_thread_fn_t)(void *);
+typedef uint8_t os_thread_prio_t;
+#define OS_THREAD_PRIORITY_DEFAULT 			2
+#define OS_THREAD_STACK_SIZE_DEFAULT 	3072
+class Thread
+{
+public:
+	Thread(const char *, os_thread_fn_t, void * = NULL, os_thread_prio_t = OS_THREAD_PRIORITY_DEFAULT,\
+		size_t = OS_THREAD_STACK_SIZE_DEFAULT) {}
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "application.h"
+#include "myDtcStats.h"
+
+// DTC statistics against hand counts:  hits and warm-up cycles as codes come
+// and go, a reload from NVM, a store with nothing changed, a store that must
+// put only the changed entry, and codes beyond capacity.  Then across reboots:
+// sightings before the first warm-up count must not open a cycle of their
+// own, and a reboot in the middle of a cycle must not count that cycle twice.
+
+static int failed = 0;
+
+// Check one entry's hits and cycles
+static void expect(const char *when, DtcStatsBase &s, const unsigned long cod, const unsigned hits, const unsigned cycles)
+{
+	const DtcStat *d = s.get(cod);
+	if ( d && d->hits==hits && d->cycles==cycles ) return;
+	printf("%s:  P%04lu hits %u cycles %u, want %u and %u\n", when, cod, d ? d->hits : 0, d ? d->cycles : 0, hits, cycles);
+	failed++;
+}
+
+// Count and report a failed expectation
+static void check(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// Counts, reload and dirty-only stores
+static void counts(void)
+{
+	const int start = 200;
+	{
+		DtcStats<4> s(true, 0);
+		s.loadNVM(start);
+		s.warmups(7);
+		s.record(1000, 2002);
+		s.record(1001, 2002);
+		s.record(1002, 133);
+		expect("one cycle", s, 2002, 2, 1);
+		s.warmups(8);
+		s.record(1003, 2002);
+		s.warmups(9);
+		s.warmups(10);
+		s.record(1004, 2002);
+		s.record(1005, 420);
+		expect("three cycles", s, 2002, 4, 3);
+		expect("one cycle", s, 133, 1, 1);
+		s.record(1006, 171);
+		s.record(1007, 300);
+		check(s.count()==4 && s.dropped()==1 && !s.get(300), "a code beyond capacity is dropped");
+		s.storeNVM(start);
+		unsigned long writes = EEPROM.writes;
+		s.storeNVM(start);
+		check(EEPROM.writes==writes, "a store with nothing changed writes nothing");
+
+		// Spoil the clean first entry in EEPROM:  a dirty-only store leaves it
+		const int first = start+sizeof(NvmHeader)+sizeof(uint16_t)+offsetof(DtcStat, hits);
+		EEPROM.write(first, EEPROM.read(first)^0x01);
+		s.record(1008, 420);
+		s.storeNVM(start);
+		check(EEPROM.read(first)==((s.getRaw(0)->hits&0xFF)^0x01), "only the changed entry is put");
+		EEPROM.write(first, EEPROM.read(first)^0x01);
+	}
+	{
+		DtcStats<4> r(true, 0);
+		r.loadNVM(start);
+		expect("reloaded", r, 2002, 4, 3);
+		expect("reloaded", r, 420, 2, 1);
+		const DtcStat *d = r.get(420);
+		check(r.count()==4 && d && d->first==1005 && d->last==1008, "reloaded times");
+	}
+}
+
+// First boot, then a reboot within a cycle
+static void reboots(void)
+{
+	const int start = 600;
+	{
+		// First boot.  2002 is seen before the count arrives and again after
+		DtcStats<16> s(true, 0);
+		s.loadNVM(start);
+		s.record(1000, 2002);
+		s.warmups(7);
+		expect("first warm-up count", s, 2002, 1, 1);
+		s.record(1001, 2002);
+		expect("same cycle", s, 2002, 2, 1);
+		s.warmups(8);
+		s.record(1002, 2002);
+		expect("next cycle", s, 2002, 3, 2);
+		s.storeNVM(start);
+	}
+	{
+		// Reboot within cycle 8.  2002 is seen again, 420 for the first time
+		DtcStats<16> s(true, 0);
+		s.loadNVM(start);
+		s.record(2000, 2002);
+		s.record(2001, 420);
+		expect("before count, known code", s, 2002, 4, 2);
+		expect("before count, new code", s, 420, 1, 0);
+		s.warmups(8);
+		expect("reboot, same cycle", s, 2002, 4, 2);
+		expect("reboot, new code", s, 420, 1, 1);
+		s.record(2002, 420);
+		s.warmups(9);
+		s.record(2003, 2002);
+		s.record(2004, 420);
+		expect("after reboot, next cycle", s, 2002, 5, 3);
+		expect("after reboot, next cycle", s, 420, 3, 2);
+		s.storeNVM(start);
+	}
+	{
+		DtcStats<16> r(true, 0);
+		r.loadNVM(start);
+		expect("reloaded", r, 2002, 5, 3);
+		expect("reloaded", r, 420, 3, 2);
+	}
+}
+
+int main()
+{
+	counts();
+	reboots();
+	printf("DTC statistics %s\n", failed ? "WRONG" : "match hand counts, store only changes, exact across reboots");
+	return failed!=0;
+}
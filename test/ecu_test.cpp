@@ -0,0 +1,181 @@
+#include "application.h"
+#include "myEcu.h"
+#include "mySubs.h"
+#include "fake_elm.h"
+
+// CAN reply demultiplexing and what the ECU set learns from it, first from
+// hand made ATH1 lines, 11 bit single frames from two ECUs, a 29 bit
+// multi-frame mode 03 reply, frames out of sequence and headed J1850 and
+// ISO 9141 lines, then through ping() against the scripted adapter on CAN and
+// on ISO 9141 with headers on, as the sketch runs it.
+
+static int failed = 0;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// True if line holds exactly the n bytes b
+static bool holds(const ObdLine &line, const uint8_t *b, const uint8_t n)
+{
+	return line.data() && line.len==n && !memcmp(line.bytes, b, n);
+}
+
+// Frames split by ECU, single and multi-frame, 11 and 29 bit
+static void demux(void)
+{
+	CanDemux d;
+	ObdLine l;
+	EcuLine m[MAX_ECUS];
+	d.begin();
+	expect(d.frame("7E8064100BE3FA813"), "7E8 single frame");
+	expect(d.frame("7E906410080000001"), "7E9 single frame");
+	expect(!d.frame("NODATA"), "NO DATA is not a frame");
+	expect(!d.frame("4100BE3FA813"), "a line without header is not a frame");
+	const uint8_t r0100[] = {0x41, 0x00, 0xBE, 0x3F, 0xA8, 0x13};
+	expect(d.primary(&l) && holds(l, r0100, 6), "primary is the lowest ID");
+	uint8_t n = d.copy(m, MAX_ECUS);
+	expect(n==2 && m[1].id==0x7E9, "both ECUs copied");
+	EcuSet e(0);
+	e.take(m, n, 0UL);
+	expect(e.count()==2 && e.supported(0x0D) && e.supported(0x01), "PID support learned");
+	expect(!e.supported(0x02) && !e.supported(0x1E), "unsupported PIDs left out");
+	expect(e.nextRange(0x00)==0x20, "0120 asked for next");
+
+	d.begin();
+	expect(d.frame("18DAF110100A430401330300"), "29 bit first frame");
+	expect(!d.primary(&l), "first frame alone is incomplete");
+	expect(d.frame("18DAF1102144012300AAAA"), "29 bit consecutive frame");
+	const uint8_t r03[] = {0x43, 0x04, 0x01, 0x33, 0x03, 0x00, 0x44, 0x01, 0x23, 0x00};
+	expect(d.primary(&l) && holds(l, r03, 10), "mode 03 reassembled");
+	n = d.copy(m, MAX_ECUS);
+	e.take(m, n, 1000UL);
+	expect(e.count()==3 && e.get(2)->codes.size()==3, "its 3 codes logged");
+	e.take(m, n, 2000UL);
+	expect(e.get(2)->codes.size()==3, "a repeat is not logged twice");
+	expect(e.resetCodes()==3 && e.get(2)->codes.numActive()==0, "codes reset after a clear");
+	e.take(m, n, 3000UL);
+	expect(e.get(2)->codes.numActive()==3, "a recurrence after the clear is logged");
+}
+
+// Support ranges chain past an ECU that claims a range and then stays silent
+static void discovery(void)
+{
+	const uint8_t a0100[] = {0x41, 0x00, 0xBE, 0x3F, 0xA8, 0x13};   // 0120 exists
+	const uint8_t b0100[] = {0x41, 0x00, 0x80, 0x00, 0x00, 0x01};   // 0120 exists
+	const uint8_t a0120[] = {0x41, 0x20, 0x80, 0x01, 0x80, 0x01};   // 0140 exists
+	EcuLine m[2];
+	m[0].id = 0x7E8;
+	m[1].id = 0x7E9;
+	m[0].line.kind = m[1].line.kind = lineData;
+	memcpy(m[0].line.bytes, a0100, 6); m[0].line.len = 6;
+	memcpy(m[1].line.bytes, b0100, 6); m[1].line.len = 6;
+	EcuSet e(0);
+	e.take(m, 2, 0UL);
+	expect(e.nextRange(0x00)==0x20, "0120 after 0100");
+	memcpy(m[0].line.bytes, a0120, 6);
+	e.take(m, 1, 0UL);    // 7E9 does not answer 0120
+	expect(e.nextRange(0x20)==0x40, "0140 after 0120 although 7E9 was silent");
+	expect(e.nextRange(0x40)==0, "nothing after 0140 until it is answered");
+}
+
+// Consecutive frames must arrive numbered in turn, 1..F then 0
+static void sequence(void)
+{
+	const char *ff 	= "7E81014490201314434";   // Mode 09 VIN style, 20 bytes
+	const char *cf1 = "7E82147303030303030";
+	const char *cf2 = "7E82231323334353637";
+	CanDemux d;
+	ObdLine l;
+	d.begin();
+	d.frame(ff); d.frame(cf1); d.frame(cf2);
+	expect(d.primary(&l) && l.len==20 && l.bytes[19]==0x37, "frames in turn reassembled");
+	d.begin();
+	d.frame(ff); d.frame(cf2); d.frame(cf1);
+	expect(!d.primary(&l), "a skipped frame discards the message");
+	d.begin();
+	d.frame(ff); d.frame(cf1); d.frame(cf1); d.frame(cf2);
+	expect(!d.primary(&l), "a repeated frame discards the message");
+	d.begin();
+	d.frame(ff); d.frame(cf1); d.frame(cf2);
+	expect(d.primary(&l), "a discarded ECU recovers on the next first frame");
+
+	// 128 bytes, more than OBD_BYTES keeps, so the numbers wrap past F
+	char cf[20];
+	d.begin();
+	d.frame("7E81080490201314434");
+	for ( int k=1; k<=18; k++ )
+	{
+		snprintf(cf, sizeof(cf), "7E82%X%02X%02X%02X%02X%02X%02X%02X", k&0x0F, k, k, k, k, k, k, k);
+		d.frame(cf);
+	}
+	expect(d.primary(&l) && l.len==OBD_BYTES, "frame numbers wrap from F to 0");
+}
+
+// Headed non-CAN lines lose header and check byte, plain ones pass
+static void unwrapped(void)
+{
+	const uint8_t rpm[] = {0x41, 0x0C, 0x1A, 0xF8};
+	const struct
+	{
+		const char *what;
+		uint8_t 		len;
+		uint8_t 		bytes[12];
+		bool 				ok;
+		uint8_t 		left;   // Bytes after unwrap, from rpm
+	} lines[] = {
+		{"J1850 PWM line, header starts as the reply", 8, {0x41, 0x6B, 0x10, 0x41, 0x0C, 0x1A, 0xF8, 0x3D}, true, 4},
+		{"J1850 VPW line", 8, {0x48, 0x6B, 0x10, 0x41, 0x0C, 0x1A, 0xF8, 0xB2}, true, 4},
+		{"ISO 9141 line, sum check", 8, {0x48, 0x6B, 0x10, 0x41, 0x0C, 0x1A, 0xF8, 0x22}, true, 4},
+		{"plain line", 4, {0x41, 0x0C, 0x1A, 0xF8}, true, 4},
+		{"PWM line with a bad check byte is left whole", 8, {0x41, 0x6B, 0x10, 0x41, 0x0C, 0x1A, 0xF8, 0x00}, true, 0},
+		{"headed line with a bad check byte", 8, {0x48, 0x6B, 0x10, 0x41, 0x0C, 0x1A, 0xF8, 0x00}, false, 0},
+		{"another mode's reply", 4, {0x43, 0x01, 0x01, 0x33}, false, 0},
+	};
+	for ( const auto &c : lines )
+	{
+		ObdLine l;
+		l.kind 	= lineData;
+		l.len 	= c.len;
+		memcpy(l.bytes, c.bytes, c.len);
+		bool ok = CanDemux::unwrap(&l, 0x41)==c.ok;
+		if ( c.ok ) ok = ok && (c.left ? holds(l, rpm, 4) : l.len==c.len);
+		expect(ok, c.what);
+	}
+}
+
+// Whole requests through ping(), headers on
+static void pings(const bool can)
+{
+	fakeElmAttach();
+	fakeElmProtocol(can);
+	rxFlushToChar(NULL, '>');   // Prompt left by the last run, as setup() flushes after ATZ
+	Serial1.println("ATH1");
+	char rx[104];  // As ObdIo's OBD_RX
+	CanDemux d;
+	ObdLine l;
+	const uint8_t rpm[] = {0x41, 0x0C, 0x1A, 0xF8};
+	expect(!ping(NULL, "010C", rx, &l, &d) && holds(l, rpm, 4), can ? "CAN 010C" : "ISO 9141 010C");
+	const uint8_t codes[] = {0x43, 0x01, 0x01, 0x33};
+	expect(!ping(NULL, "03", rx, &l, &d) && holds(l, codes, 4), can ? "CAN 03" : "ISO 9141 03");
+	expect(ping(NULL, "0142", rx, &l, &d) && !l.data(), can ? "CAN NO DATA" : "ISO 9141 NO DATA");
+	EcuLine m[MAX_ECUS];
+	ping(NULL, "0100", rx, &l, &d);
+	expect(d.copy(m, MAX_ECUS)==(can ? 2 : 0), "ECUs told apart on CAN only");
+}
+
+int main()
+{
+	demux();
+	discovery();
+	sequence();
+	unwrapped();
+	pings(true);
+	pings(false);
+	printf("CAN demultiplexing %s\n", failed ? "WRONG" : "and non-CAN fallback correct");
+	return failed!=0;
+}
@@ -0,0 +1,105 @@
+#include "application.h"
+#include <thread>
+#include "fake_elm.h"
+
+static bool 											headers 	= false;  // ATH1 seen
+static bool 											can 			= true;   // Else ISO 9141
+static std::atomic<bool> 					held(false);
+static std::atomic<unsigned long> requests(0UL);
+
+// Answers by command.  Each ECU's reply is its data bytes with PCI, as on the bus
+static const struct
+{
+	const char *cmd;
+	const char *ecu7E8;
+	const char *ecu7E9;
+} answers[] = {
+	{"0100", "06 41 00 BE 3F A8 13", "06 41 00 80 00 00 01"},
+	{"0120", "06 41 20 80 01 80 01", NULL},   // 7E9 claims 0120 in its 0100, then stays silent
+	{"0140", "06 41 40 00 00 00 00", NULL},
+	{"0101", "06 41 01 81 07 65 04", "06 41 01 00 04 00 00"},
+	{"0105", "03 41 05 5A",          NULL},
+	{"010C", "04 41 0C 1A F8",       NULL},
+	{"010D", "03 41 0D 3C",          NULL},
+	{"0130", "03 41 30 05",          NULL},
+	{"0131", "04 41 31 01 F4",       NULL},
+	{"03",   "04 43 01 01 33",       "02 43 00"},
+	{"07",   "02 47 00",             NULL},
+	{"04",   "01 44",                NULL},
+};
+
+// One ECU's answer line
+static void answer(const char *id, const char *data)
+{
+	if ( !can )
+	{ // Priority, target and source address ahead, checksum after
+		char line[64];
+		const char *source = !strcmp(id, "7E8") ? "10" : "18";
+		unsigned sum = 0x48 + 0x6B + strtoul(source, NULL, 16);
+		for ( const char *p=data+2; *p; p+=3 ) sum += strtoul(p+1, NULL, 16);
+		if ( headers ) snprintf(line, sizeof(line), "48 6B %s %s %02X\r", source, data+3, sum&0xFF);
+		else 					 snprintf(line, sizeof(line), "%s\r", data+3);
+		Serial1.feed(line);
+		return;
+	}
+	if ( headers )
+	{
+		Serial1.feed(id);
+		Serial1.feed(" ");
+		Serial1.feed(data);
+	}
+	else Serial1.feed(data+3);  // Without headers the PCI is hidden too
+	Serial1.feed("\r");
+}
+
+// Serial1 line responder
+static void respond(const char *cmd)
+{
+	requests++;
+	while ( held ) std::this_thread::yield();
+	Serial1.feed(cmd);
+	Serial1.feed("\r");
+	if ( !strcmp(cmd, "ATZ") ) 					Serial1.feed("\r\rELM327 v1.5\r");
+	else if ( !strcmp(cmd, "ATH1") ) 		{ headers = true;  Serial1.feed("OK\r"); }
+	else if ( !strcmp(cmd, "ATH0") ) 		{ headers = false; Serial1.feed("OK\r"); }
+	else if ( !strncmp(cmd, "AT", 2) ) 	Serial1.feed("OK\r");
+	else
+	{
+		bool found = false;
+		for ( const auto &a : answers )
+		{
+			if ( strcmp(cmd, a.cmd) ) continue;
+			answer("7E8", a.ecu7E8);
+			if ( a.ecu7E9 ) answer("7E9", a.ecu7E9);
+			found = true;
+		}
+		if ( !found ) Serial1.feed("NO DATA\r");
+	}
+	Serial1.feed("\r>");
+}
+
+// Answer from now on
+void fakeElmAttach()
+{
+	headers 				= false;
+	can 						= true;
+	Serial1.onLine 	= respond;
+}
+
+// Hold back every answer until released, as a slow bus does
+void fakeElmHold(const bool hold)
+{
+	held = hold;
+}
+
+// CAN or ISO 9141 answers
+void fakeElmProtocol(const bool isCan)
+{
+	can = isCan;
+}
+
+// Commands seen
+unsigned long fakeElmRequests()
+{
+	return requests;
+}
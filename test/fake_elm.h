@@ -0,0 +1,14 @@
+#ifndef _fake_elm_h
+#define _fake_elm_h
+
+// Scripted ELM327 on Serial1.  Echoes each command and answers it from a table
+// of two CAN ECUs, 7E8 engine and 7E9 transmission, the way the adapter prints
+// with or without ATH1.  Unknown requests get NO DATA.  fakeElmProtocol(false)
+// puts the same ECUs on ISO 9141 instead, addresses 10 and 18.  fakeElmHold(true)
+// stalls each answer until released, from another thread.
+void fakeElmAttach(void);
+void fakeElmHold(const bool hold);
+void fakeElmProtocol(const bool can);
+unsigned long fakeElmRequests(void);
+
+#endif
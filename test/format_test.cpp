@@ -0,0 +1,64 @@
+#include "application.h"
+#include "myFormat.h"
+#include <limits.h>
+
+// TextBuf formatters against snprintf, including the extremes of a 64 bit
+// host long that overflowed the Photon-sized scratch buffers
+
+static int failed = 0;
+
+// Compare one result with what printf would make
+static void expect(const char *what, const TextBuf &got, const char *want)
+{
+	if ( strcmp(got.c_str(), want) )
+	{
+		printf("%s:  got [%s] want [%s]\n", what, got.c_str(), want);
+		failed++;
+	}
+}
+
+int main()
+{
+	const long ints[] = {0, 1, -1, 9, -9, 1234, -1234, 65535, LONG_MAX, LONG_MIN, LONG_MIN+1};
+	char want[64];
+	for ( long v : ints )
+	{
+		for ( uint8_t width : {0, 5, 12, 22} )
+		{
+			FixedText<40> t;
+			t.addInt(v, width);
+			snprintf(want, sizeof(want), "%*ld", width, v);
+			expect("addInt", t, want);
+			t.clear();
+			t.addInt(v, width, '0');
+			snprintf(want, sizeof(want), "%0*ld", width, v);
+			expect("addInt 0", t, want);
+			t.clear();
+			t.addUns((unsigned long)v, width);
+			snprintf(want, sizeof(want), "%*lu", width, (unsigned long)v);
+			expect("addUns", t, want);
+		}
+		for ( uint8_t decimals : {0, 1, 3} )
+		{
+			if ( v==LONG_MIN || v==LONG_MAX || v==LONG_MIN+1 ) continue;  // Beyond double precision
+			FixedText<40> t;
+			t.addFixed(v, decimals, 8);
+			double scale = 1.0;
+			for ( uint8_t i=0; i<decimals; i++ ) scale *= 10.0;
+			snprintf(want, sizeof(want), "%*.*f", 8, decimals, v/scale);
+			expect("addFixed", t, want);
+		}
+	}
+	FixedText<40> big;
+	big.addFixed(LONG_MIN, 2);
+	printf("addFixed(LONG_MIN, 2) = %s\n", big.c_str());
+	big.clear();
+	big.addUns(ULONG_MAX);
+	snprintf(want, sizeof(want), "%lu", ULONG_MAX);
+	expect("addUns max", big, want);
+	FixedText<4> small;
+	small.addInt(-123456, 8);
+	expect("truncated", small, " -12");
+	printf("%s\n", failed ? "formatter mismatches" : "formatters match printf");
+	return failed;
+}
@@ -0,0 +1,69 @@
+#include "application.h"
+#include "myQueue.h"
+#include "myFreeze.h"
+
+// Freeze frames as the confirmed fault queue triggers them:  one capture per
+// logged occurrence, a fresh one when a reset fault recurs, and the oldest
+// frame recycled once the table is full.
+
+static int failed = 0;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// Answer the batch begin() hands out, rpm from the frame at rpm/4
+static void capture(FreezeFramesBase &frames, const uint16_t rpm)
+{
+	int n = frames.begin();
+	for ( int i=0; i<n; i++ )
+	{
+		ObdLine l;
+		char rx[32];
+		const char *cmd = FreezeFramesBase::cmd(i);
+		if ( !strcmp(cmd, "020C00") ) snprintf(rx, sizeof(rx), "420C00%04X", rpm*4);
+		else 													snprintf(rx, sizeof(rx), "NODATA");
+		tokenize(rx, &l);
+		frames.take(cmd, l.data(), l.span());
+	}
+}
+
+// rpm held in the frame of cod, 0 if none
+static unsigned rpmOf(FreezeFramesBase &frames, const unsigned long cod)
+{
+	const FreezeFrame *f = frames.get(cod);
+	return f && (f->have & 0x08) ? (f->data[2]*256+f->data[3])/4 : 0;
+}
+
+int main()
+{
+	Queue<8> F(0, "F", false, 0);
+	FreezeFrames<2> frames(0);
+	F.attach(&frames);
+
+	F.newCode(1000, 133);
+	capture(frames, 2000);
+	expect(rpmOf(frames, 133)==2000 && frames.get(133)->time==1000, "frame of a newly logged fault");
+
+	F.newCode(1100, 133);
+	expect(!frames.pending(), "a repeat sighting does not capture again");
+
+	F.resetAll();
+	F.newCode(5000, 133);
+	expect(frames.pending() && frames.get(133)->time==5000, "a recurrence after reset re-arms the frame");
+	capture(frames, 3100);
+	expect(rpmOf(frames, 133)==3100 && frames.count()==1, "the frame is of the recurrence, in the same slot");
+
+	F.newCode(6000, 171);
+	capture(frames, 900);
+	F.newCode(7000, 300);
+	capture(frames, 4000);
+	expect(frames.count()==2 && !frames.get(133) && rpmOf(frames, 300)==4000, "full table recycles its oldest frame");
+
+	printf("freeze frames %s\n", failed ? "WRONG" : "follow each logged occurrence");
+	return failed!=0;
+}
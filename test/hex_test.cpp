@@ -0,0 +1,66 @@
+#include "application.h"
+#include "myResponse.h"
+#include <chrono>
+
+// hexDecode against a character at a time reference on random text that is
+// mostly hex with spaces, prompts, high-bit bytes and odd tails mixed in, then
+// timed against the per-pair strtol it replaced on an ATMA-sized buffer.
+
+// Nibble of one hex character, -1 if not hex
+static int nibble(const char c)
+{
+	if ( c>='0' && c<='9' ) return c-'0';
+	if ( c>='A' && c<='F' ) return c-'A'+10;
+	if ( c>='a' && c<='f' ) return c-'a'+10;
+	return -1;
+}
+
+int main()
+{
+	const char hex[] 	= "0123456789ABCDEF";
+	const char other[] = "0123456789ABCDEFabcdef G>\r\x80\xff/:@`g";
+	srand(1);
+	unsigned long bad = 0UL;
+	const int cases = 2000000;
+	for ( int t=0; t<cases; t++ )
+	{
+		char s[40];
+		int n = rand()%36;
+		for ( int i=0; i<n; i++ ) s[i] = rand()%8 ? hex[rand()%16] : other[rand()%(sizeof(other)-1)];
+		uint8_t got[20];
+		uint8_t want[20];
+		int k = 0;
+		for ( ; k<n/2; k++ )
+		{
+			int a = nibble(s[2*k]);
+			int b = nibble(s[2*k+1]);
+			if ( a<0 || b<0 ) break;
+			want[k] = a<<4 | b;
+		}
+		if ( hexDecode(s, n, got)!=k || memcmp(got, want, k) ) bad++;
+	}
+	printf("%d random lines, %lu decoded differently from the reference\n", cases, bad);
+
+	static char big[8192];
+	static uint8_t out[4096];
+	for ( int i=0; i<8192; i++ ) big[i] = hex[(i*7+i/3)%16];
+	volatile unsigned long sink = 0UL;
+	const int reps = 2000;
+	auto t0 = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ )
+	{
+		for ( int i=0; i<8192; i+=2 )
+		{
+			char pair[3] = {big[i], big[i+1], '\0'};
+			out[i/2] = strtol(pair, NULL, 16);
+		}
+		sink += out[r%4096];
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ ) sink += hexDecode(big, 8192, out);
+	auto t2 = std::chrono::steady_clock::now();
+	double old = std::chrono::duration<double>(t1-t0).count()*1e9/(reps*8192.0);
+	double now = std::chrono::duration<double>(t2-t1).count()*1e9/(reps*8192.0);
+	printf("8 KB of hex:  strtol pairs %.2f ns/char, hexDecode %.2f ns/char, %.1fx\n", old, now, old/now);
+	return bad!=0;
+}
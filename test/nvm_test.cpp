@@ -0,0 +1,175 @@
+#include "application.h"
+#include "myNvm.h"
+#include "myQueue.h"
+
+// Fault queue NVM against the RAM EEPROM in application.h.  A random run
+// stores and reloads the queue into a fresh one, which must match.  A
+// simulated day then counts the bytes the journal writes, next to what
+// rewriting both queues on every store used to write.  The snapshot CRC must
+// give the standard check value and catch a flipped bit.  The region
+// directory must keep regions across boots and drop moved ones.  A drive with
+// a tiny journal forces frequent snapshots, which should put only the dirty
+// slots.
+
+static int failed = 0;
+
+// Same entries, order and counts
+static bool same(QueueBase &a, QueueBase &b)
+{
+	if ( a.size()!=b.size() || a.numActive()!=b.numActive() ) return false;
+	if ( a.IsEmpty() ) return true;
+	if ( a.front()!=b.front() || a.rear()!=b.rear() ) return false;
+	for ( int i=0; i<a.size(); i++ )
+	{
+		int k = (a.front()+i)%a.maxSize();
+		FaultCode x = a.getRaw(k);
+		FaultCode y = b.getRaw(k);
+		if ( x.time!=y.time || x.code!=y.code || x.reset!=y.reset ) return false;
+	}
+	return true;
+}
+
+// Random changes with a store and reload every tenth or so
+static void roundTrip(void)
+{
+	srand(3);
+	Queue<60> q(0, "Q", true, 0);
+	q.loadNVM(1);
+	int bad = 0;
+	int fails = 0;
+	for ( int k=0; k<100000; k++ )
+	{
+		int op = rand()%100;
+		unsigned long cod = 1+rand()%80;
+		if ( op<60 ) q.newCode(k, cod);
+		else if ( op<63 ) q.resetAll();
+		else if ( op<70 ) q.Dequeue();
+		if ( rand()%10 ) continue;
+		if ( q.storeNVM(1)<0 ) fails++;
+		Queue<60> r(0, "R", true, 0);
+		r.loadNVM(1);
+		if ( !same(q, r) ) bad++;
+	}
+	printf("round trip:  %d reloads differ, %d stores failed\n", bad, fails);
+	failed += bad+fails;
+}
+
+// 960 report cycles of 90 s, both queues stored twice a cycle, a few new
+// codes and one reset
+static void day(void)
+{
+	Queue<60> F(0, "F", true, 0);
+	Queue<60> I(0, "I", true, 0);
+	int s = 1;
+	int e = F.loadNVM(s);
+	I.loadNVM(e);
+	F.storeNVM(s);
+	I.storeNVM(e);
+	unsigned long b0 = F.nvmBytes()+I.nvmBytes();
+	unsigned long w0 = EEPROM.writes;
+	for ( int c=0; c<960; c++ )
+	{
+		if ( c%160==5 )  F.newCode(c, 100+c%7);
+		if ( c%160==50 ) I.newCode(c, 200+c%5);
+		if ( c==900 ) { F.resetAll(); I.resetAll(); }
+		for ( int t=0; t<2; t++ ) { F.storeNVM(s); I.storeNVM(e); }
+	}
+	unsigned long bytes = F.nvmBytes()+I.nvmBytes()-b0;
+	unsigned long full 	= 960UL*2*2*(12+60*7);
+	printf("day:  journal wrote %lu bytes (%lu changed), full rewrites %lu\n", bytes, EEPROM.writes-w0, full);
+	if ( bytes*100>full ) failed++;
+}
+
+// CRC32 check value, chained calls, and a queue reload after a bit flip
+static void crc(void)
+{
+	const char *digits = "123456789";
+	bool value 	= crc32(0, digits, 9)==0xCBF43926UL;
+	bool chain 	= crc32(crc32(0, digits, 4), digits+4, 5)==crc32(0, digits, 9);
+	Queue<60> q(0, "Q", true, 0);
+	for ( int k=0; k<20; k++ ) q.newCode(k, 1+k);
+	q.resetAll();
+	q.storeNVM(1);
+	int at = 1+sizeof(NvmHeader)+3*sizeof(int)+sizeof(uint32_t)+5*sizeof(FaultRecord);
+	EEPROM.write(at, EEPROM.read(at)^0x04);
+	Queue<60> r(0, "R", true, 0);
+	r.loadNVM(1);
+	bool caught = r.IsEmpty();
+	printf("crc:  check value %s, chained %s, flipped bit %s\n", value ? "ok" : "WRONG",\
+		chain ? "ok" : "WRONG", caught ? "reinitializes" : "LOADED");
+	failed += !value + !chain + !caught;
+}
+
+// Region directory across three boots:  fresh, same layout, one region grown
+static void directory(void)
+{
+	static_assert(nvmBudget(100, 200)==nvmDirSize+300, "budget adds the directory");
+	int fresh, same, grown;
+	{
+		NvmMap m(2047, 0);
+		m.add("A", 100);
+		m.add("B", 200);
+		fresh = m.begin();
+	}
+	bool kept;
+	{
+		NvmMap m(2047, 0);
+		int a = m.add("A", 100);
+		int b = m.add("B", 200);
+		same = m.begin();
+		kept = m.kept(a) && m.kept(b) && m.start(a)==nvmDirSize && m.start(b)==nvmDirSize+100;
+	}
+	bool moved;
+	bool full;
+	{
+		NvmMap m(2047, 0);
+		int a = m.add("A", 120);
+		int b = m.add("B", 200);
+		full = m.add("C", 2047)<0;
+		grown = m.begin();
+		moved = !m.kept(a) && !m.kept(b);
+	}
+	NvmMap m(2047, 0);
+	m.add("A", 120);
+	m.add("B", 200);
+	bool stored = m.begin()==2;
+	printf("directory:  kept %d, %d, %d of 2;  %s\n", fresh, same, grown,\
+		kept && moved && full && stored ? "placement ok" : "WRONG");
+	failed += fresh!=0 || same!=2 || grown!=0 || !kept || !moved || !full || !stored;
+}
+
+// 960 cycles with a 4 slot journal, a random code about every tenth cycle and
+// a reset every 200.  Putting every slot on each snapshot wrote 8456 bytes
+static void drive(void)
+{
+	srand(9);
+	Queue<60, 4> F(0, "F", true, 0);
+	F.loadNVM(1);
+	F.storeNVM(1);
+	unsigned long b0 = F.nvmBytes();
+	unsigned long p0 = F.nvmWrites();
+	unsigned long w0 = EEPROM.writes;
+	for ( int c=0; c<960; c++ )
+	{
+		if ( rand()%10==0 ) F.newCode(c, 1+rand()%300);
+		if ( c%200==199 ) F.resetAll();
+		F.storeNVM(1);
+		F.storeNVM(1);
+	}
+	Queue<60, 4> R(0, "R", true, 0);
+	R.loadNVM(1);
+	unsigned long bytes = F.nvmBytes()-b0;
+	printf("drive:  snapshots wrote %lu bytes in %lu puts (%lu changed), reload %s\n", bytes, F.nvmWrites()-p0,\
+		EEPROM.writes-w0, same(F, R) ? "matches" : "DIFFERS");
+	if ( !same(F, R) || bytes>8456/2 ) failed++;
+}
+
+int main()
+{
+	roundTrip();
+	day();
+	crc();
+	directory();
+	drive();
+	return failed!=0;
+}
@@ -0,0 +1,136 @@
+#include "application.h"
+#include <thread>     // Ahead of mySubs.h, whose OLED swap macro breaks them
+#include <algorithm>
+#include "myObdIo.h"
+#include "myQueue.h"
+#include "mySubs.h"
+#include "fake_elm.h"
+
+// The SPSC ring between two threads, then ObdIo under load against the scripted
+// adapter, headers on as the sketch runs it.  A producer thread pushes 200k
+// sequenced values through a small ring and the consumer must see every one, in
+// order.  The UI side then keeps the request queue full, checks that every
+// reply comes back in order with the right status, drains the I/O thread's log
+// and takes the bus time as taskDisplay does.  Prints throughput and the
+// latency from submit to poll at the median and the tail.  pending() must count
+// a request the I/O thread has taken but not answered, since taskTrend and
+// taskFreeze read 0 as an idle bus;  it is checked under load and with the
+// adapter held.  verbose 5 makes the I/O thread log every adapter byte, the
+// most it ever writes.
+
+extern int 												verbose;
+extern std::atomic<unsigned long> busMicros;
+
+static const struct
+{
+	const char 	*cmd;
+	int8_t 			status;
+} script[] = {{"010C", 0}, {"010D", 0}, {"0105", 0}, {"0101", 0}, {"03", 0}, {"0142", 1}};
+
+// Sequenced values through an 8 slot ring.  Returns values lost or reordered
+static int ring(void)
+{
+	const uint32_t n = 200000UL;
+	static SpscQueue<uint32_t, 8> q;
+	std::thread producer([]()
+	{
+		for ( uint32_t i=0; i<n; )
+		{
+			if ( q.push(i) ) i++;
+			else std::this_thread::yield();
+		}
+	});
+	int bad = 0;
+	for ( uint32_t want=0; want<n; )
+	{
+		uint32_t v;
+		if ( !q.pop(&v) ) { std::this_thread::yield(); continue; }
+		if ( v!=want ) bad++;
+		want = v+1;
+	}
+	producer.join();
+	printf("ring:  %lu values, %d lost or out of order\n", (unsigned long)n, bad);
+	return bad;
+}
+
+int main()
+{
+	int bad = ring();
+
+	const int n = 20000;
+	static unsigned long latency[n];
+	verbose = 5;
+	fakeElmAttach();
+	Serial1.println("ATH1");    // Headers on and the first prompt left, as setup() does
+	ObdIo obd(verbose);
+	obd.start();
+
+	const int kinds = sizeof(script)/sizeof(script[0]);
+	int sent = 0;
+	int got = 0;
+	int idleWrong = 0;  // pending() read 0 with a request still on the bus
+	unsigned long bus = 0UL;
+	unsigned long logged = 0UL;
+	unsigned long t0 = micros();
+	while ( got<n )
+	{
+		while ( sent<n && obd.pending()<OBD_QUEUE-1 && obd.submit(obdPing, script[sent%kinds].cmd, NULL, sent&0xFF, micros()) )
+			sent++;
+		bool idle = obd.pending()==0;
+		ObdReply reply;
+		while ( obd.poll(&reply) )
+		{
+			latency[got] = micros()-reply.time;
+			int k = got%kinds;
+			if ( reply.tag!=(got&0xFF) || strcmp(reply.cmd, script[k].cmd) || (reply.status!=0)!=(script[k].status!=0) )
+			{
+				if ( bad++<5 ) printf("reply %d:  %s tag %u status %d\n", got, reply.cmd, reply.tag, reply.status);
+			}
+			got++;
+		}
+		if ( idle && got<sent ) idleWrong++;
+		logged += obd.drainLog(&Serial);
+		bus += busMicros.exchange(0UL);
+		std::this_thread::yield();
+	}
+	unsigned long elapsed = micros()-t0;
+
+	// A request held on the bus, as taskFreeze finds one when it looks for idle
+	fakeElmHold(true);
+	unsigned long seen = fakeElmRequests();
+	obd.submit(obdPing, "010C", NULL, 0, 0UL);
+	while ( fakeElmRequests()==seen ) std::this_thread::yield();
+	if ( obd.pending()!=1 ) idleWrong++;
+	fakeElmHold(false);
+	ObdReply reply;
+	while ( !obd.poll(&reply) ) std::this_thread::yield();
+	if ( obd.pending()!=0 ) idleWrong++;
+	// A silent adapter costs the I/O thread its polls and NOCONN_WAIT, not 5 s
+	// more, and its note reaches the console only through the log
+	struct : public Print
+	{
+		std::string text;
+		virtual size_t write(uint8_t c) { text += (char)c; return 1; }
+	} note;
+	Serial1.onLine = NULL;
+	unsigned long ms = millis();
+	obd.submit(obdPing, "010C", NULL, 0, 0UL);
+	while ( !obd.poll(&reply) ) std::this_thread::yield();
+	ms = millis()-ms;
+	obd.drainLog(&note);
+	const unsigned long polls = 2*99*150UL;  // Both rxFlushToChar calls give up after 99 empty 150 ms polls
+	bool silentOk = reply.status!=0 && ms<=polls+NOCONN_WAIT && note.text.find("No conn>")!=std::string::npos;
+	obd.stop();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	logged += obd.drainLog(&Serial);
+	bus += busMicros.exchange(0UL);
+
+	std::sort(latency, latency+n);
+	printf("%d requests in %lu ms, %lu per s, bus %lu ms\n", n, elapsed/1000, n*1000000UL/elapsed, bus/1000);
+	printf("latency us:  p50 %lu  p99 %lu  p99.9 %lu  max %lu\n", latency[n/2], latency[n*99/100], latency[n*999/1000],\
+		latency[n-1]);
+	printf("I/O log:  %lu bytes drained, %lu lost; %d replies wrong, %d idle while busy\n", logged, obd.logLost(), bad,\
+		idleWrong);
+	printf("silent adapter:  %lu ms on the I/O thread%s\n", ms, silentOk ? "" : ", WRONG");
+	return bad>0 || idleWrong>0 || !silentOk || logged==0 || bus==0;
+}
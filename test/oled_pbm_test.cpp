@@ -0,0 +1,93 @@
+#include "application.h"
+#include "SparkFunMicroOLED.h"
+
+// Golden image test of the MicroOLED host backend.  Each scene is drawn,
+// captured by pbmFileSink on display() and compared byte for byte with its
+// reference in golden/.  --update rewrites the references instead.
+
+// Draws one scene, calling display() once per frame
+typedef void (*Scene)(MicroOLED *oled);
+
+// Each font at its home position, one frame per font
+static void fonts(MicroOLED *oled)
+{
+	const char *text[] = {"No conn>", "P2002", "0123", "1.2-", "88", "01", "01"};
+	for ( uint8_t f=0; f<oled->getTotalFonts(); f++ )
+	{
+		oled->clear(PAGE);
+		oled->setFontType(f);
+		oled->setCursor(0, 0);
+		oled->print(text[f]);
+		oled->display();
+	}
+}
+
+// Inverse and XOR drawing over shapes
+static void shapes(MicroOLED *oled)
+{
+	oled->clear(PAGE);
+	oled->rect(0, 0, 64, 48);
+	oled->circle(32, 24, 20);
+	oled->line(0, 47, 63, 0);
+	oled->display();
+	oled->rectFill(8, 8, 48, 16, WHITE, XOR);
+	oled->setFontType(0);
+	oled->setColor(BLACK);
+	oled->setCursor(10, 12);
+	oled->print("XOR");
+	oled->setColor(WHITE);
+	oled->display();
+}
+
+static const struct
+{
+	const char 	*name;
+	Scene 			draw;
+} scenes[] = {{"golden/fonts.pbm", fonts}, {"golden/shapes.pbm", shapes}};
+
+// Read a whole file, empty if missing
+static std::string slurp(const char *path)
+{
+	std::string s;
+	FILE *f = fopen(path, "rb");
+	if ( !f ) return s;
+	int c;
+	while ( (c=fgetc(f))!=EOF ) s += (char)c;
+	fclose(f);
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	bool update = argc>1 && !strcmp(argv[1], "--update");
+	int failed = 0;
+	for ( const auto &s : scenes )
+	{
+		MicroOLED oled;
+		oled.begin();
+		const char *path = update ? s.name : "build/frames.pbm";
+		FILE *f = fopen(path, "wb");
+		if ( !f ) { printf("cannot write %s\n", path); return 1; }
+		oled.setFrameSink(MicroOLED::pbmFileSink, f);
+		s.draw(&oled);
+		fclose(f);
+
+		// writePBM streams the same last frame the sink wrote
+		Serial.capture = true;
+		Serial.out.clear();
+		oled.writePBM(Serial);
+		Serial.capture = false;
+		std::string got = slurp(path);
+		bool lastSame = got.size()>=Serial.out.size() && !got.compare(got.size()-Serial.out.size(), Serial.out.size(), Serial.out);
+		if ( update )
+		{
+			printf("%s:  %lu frames written\n", s.name, oled.getFrameCount());
+			continue;
+		}
+		bool same = got==slurp(s.name);
+		printf("%s:  %lu frames, %s%s\n", s.name, oled.getFrameCount(), same ? "match" : "DIFFER",\
+			lastSame ? "" : ", writePBM disagrees with sink");
+		if ( !same || !lastSame ) failed++;
+	}
+	return failed;
+}
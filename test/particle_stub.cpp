@@ -0,0 +1,25 @@
+#include "application.h"
+#include <chrono>
+
+USARTSerial 	Serial, Serial1;
+EEPROMClass 	EEPROM;
+TimeClass 		Time;
+WiFiClass 		WiFi;
+SystemClass 	System;
+std::atomic<unsigned long> stubMillis(0UL);
+
+unsigned long millis()
+{
+	return stubMillis;
+}
+
+unsigned long micros()
+{
+	return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(\
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void delay(unsigned long ms)
+{
+	stubMillis += ms;
+}
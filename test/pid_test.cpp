@@ -0,0 +1,71 @@
+#include "application.h"
+#include "myPids.h"
+#include <chrono>
+#include <cmath>
+
+// PidInfo's integer conversions against the float formulas they replaced,
+// over every input the adapter can send, then the cost of format() against
+// the old sprintf("%5.0f") into a String.  The rows mirror livePids in the
+// sketch.
+
+static const PidInfo pids[] = {
+//  pid     jump     unit     bytes shift offset  scale    add  width
+  {"010D", "60",    "  mph",  1,    0,    0,     KPH_MPH,  0,   5},   // kph
+  {"010C", "900",   "  rpm",  2,    2,    0,     Q24(1),   0,   5},   // quarter rpm
+  {"0131", "65535", "  mi",   2,    0,    0,     KPH_MPH,  0,   6},   // km
+  {"0105", "215",   "  F",    1,    0,  -40,     C_F,      32,  7}};  // C
+static const double exact[] = {0.621371, 1.0, 0.621371, 1.8};
+
+int main()
+{
+	int bad = 0;
+	int ties = 0;
+	for ( int p=0; p<4; p++ )
+	{
+		const PidInfo &P = pids[p];
+		long inputs = P.bytes==1 ? 256L : 65536L;
+		for ( long a=0; a<inputs; a++ )
+		{
+			uint8_t b[4] = {0x41, 0x00, (uint8_t)(P.bytes==1 ? a : a>>8), (uint8_t)a};
+			long value = P.decode(ByteSpan(b, 2+P.bytes).from(2));
+			if ( value!=(a>>P.shift)+P.offset ) bad++;
+			double want = value*exact[p]+P.add;
+			long shown = P.display(value);
+			if ( shown==lround(want) ) continue;
+			if ( fabs(shown-want)<=0.51 ) ties++;   // Q24 rounding of the factor, at a half
+			else bad++;
+		}
+	}
+	printf("every input byte and word:  %d conversions wrong, %d halfway ties within 0.51\n", bad, ties);
+
+	FixedText<16> s;
+	pids[3].format(pids[3].decode(ByteSpan((const uint8_t *)"\x41\x05\x00", 3).from(2)), true, &s);
+	if ( strcmp(s.c_str(), "    -40  F") ) { printf("format -40 F:  [%s]\n", s.c_str()); bad++; }
+	s.clear();
+	pids[3].format(0, false, &s);
+	if ( strcmp(s.c_str(), "   ----  F") ) { printf("format failed sample:  [%s]\n", s.c_str()); bad++; }
+
+	const int reps = 2000000;
+	char buf[100];
+	String str;
+	volatile unsigned long sink = 0UL;
+	auto t0 = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ )
+	{
+		snprintf(buf, sizeof(buf), "%5.0f  mph", float(r&255)*0.6);
+		str = String(buf);
+		sink += str.length();
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for ( int r=0; r<reps; r++ )
+	{
+		s.clear();
+		pids[0].format(r&255, true, &s);
+		sink += s.length();
+	}
+	auto t2 = std::chrono::steady_clock::now();
+	double old = std::chrono::duration<double>(t1-t0).count()*1e9/reps;
+	double now = std::chrono::duration<double>(t2-t1).count()*1e9/reps;
+	printf("per value:  sprintf and String %.1f ns, PidInfo::format %.1f ns, %.1fx\n", old, now, old/now);
+	return bad!=0;
+}
@@ -0,0 +1,88 @@
+#include "application.h"
+#include <math.h>
+#include "myPidStats.h"
+
+// Streaming PID statistics against brute force:  the window against a rescan
+// of the last W samples, all time against a two-pass double reference.  Then
+// the cost of add(), which must stay integer only.
+
+static int failed = 0;
+
+// Count and report a failed comparison
+static void expect(const bool ok, const char *what, const unsigned long i)
+{
+	if ( ok ) return;
+	if ( failed++<5 ) printf("failed at sample %lu:  %s\n", i, what);
+}
+
+// Relative or absolute closeness for float results
+static bool near(const double a, const double b, const double tol)
+{
+	return fabs(a-b)<=tol*(1.0+fabs(b));
+}
+
+// Mixed samples:  a slow walk with spikes, in rpm range
+static long sample(unsigned long *seed)
+{
+	static long walk = 800;
+	*seed = *seed*1103515245UL + 12345UL;
+	unsigned long r = (*seed>>16) & 0x7FFF;
+	walk += (long)(r%41) - 20;
+	if ( walk<0 ) walk = 0;
+	return r%97==0 ? walk*4 : walk;
+}
+
+int main()
+{
+	const int W = 7;
+	const unsigned long n = 20000UL;
+	static long all[n];
+	PidStats<W> s("rpm");
+	unsigned long seed = 1;
+	for ( unsigned long i=0; i<n; i++ )
+	{
+		long v = sample(&seed);
+		all[i] = v;
+		s.add(v);
+
+		unsigned long from = i+1>W ? i+1-W : 0;
+		long lo = all[from], hi = all[from];
+		double sum = 0.0, sq = 0.0;
+		for ( unsigned long k=from; k<=i; k++ )
+		{
+			if ( all[k]<lo ) lo = all[k];
+			if ( all[k]>hi ) hi = all[k];
+			sum += all[k];
+		}
+		unsigned long m = i+1-from;
+		double mean = sum/m;
+		for ( unsigned long k=from; k<=i; k++ ) sq += (all[k]-mean)*(all[k]-mean);
+		expect(s.wCount()==m && s.wMin()==lo && s.wMax()==hi, "window count, min or max", i);
+		expect(near(s.wMean(), mean, 1e-5) && near(s.wStddev(), m>1 ? sqrt(sq/(m-1)) : 0.0, 1e-4), "window mean or sd", i);
+	}
+
+	double sum = 0.0, sq = 0.0;
+	long lo = all[0], hi = all[0];
+	for ( unsigned long k=0; k<n; k++ )
+	{
+		sum += all[k];
+		if ( all[k]<lo ) lo = all[k];
+		if ( all[k]>hi ) hi = all[k];
+	}
+	double mean = sum/n;
+	for ( unsigned long k=0; k<n; k++ ) sq += (all[k]-mean)*(all[k]-mean);
+	expect(s.count()==n && s.min()==lo && s.max()==hi, "all time count, min or max", n);
+	expect(near(s.mean(), mean, 1e-5) && near(s.stddev(), sqrt(sq/(n-1)), 1e-4), "all time mean or sd", n);
+
+	// A steady channel far from zero, where plain sums of squares would cancel
+	PidStats<W> c("coolant");
+	for ( unsigned long i=0; i<n; i++ ) c.add(i&1 ? 91 : 90);
+	expect(near(c.mean(), 90.5, 1e-6) && near(c.stddev(), 0.5, 1e-3), "steady channel mean or sd", n);
+
+	unsigned long t0 = micros();
+	for ( int r=0; r<50; r++ )
+		for ( unsigned long i=0; i<n; i++ ) s.add(all[i]);
+	double ns = (micros()-t0)*1000.0/(50*n);
+	printf("%lu samples, window %d:  %s;  add() %.1f ns per sample\n", n, W, failed ? "WRONG" : "matches brute force", ns);
+	return failed!=0;
+}
@@ -0,0 +1,142 @@
+#include "application.h"
+#include "myQueue.h"
+
+// Fault queue against a plain scan of its ring.  Random newCode, reset,
+// dequeue and raw loads at the 30 the sketch uses and at 256 and 4096; after
+// each newCode its duplicate answer must match the scan, and every few
+// operations the kept active and inactive counts must match a recount.  Then
+// times newCode on a full queue of distinct codes, the worst case for the old
+// modulo walk, next to that walk.  The filtered ranges are checked in both
+// directions against an index walk.
+
+static int failed = 0;
+
+// Any unreset entry with code cod, by walking the ring from front
+static bool scanFind(QueueBase &q, const unsigned long cod)
+{
+	for ( int i=0; i<q.size(); i++ )
+	{
+		FaultCode f = q.getRaw((q.front()+i)%q.maxSize());
+		if ( !f.reset && f.code==cod ) return true;
+	}
+	return false;
+}
+
+// Recount unreset and reset entries; true if the queue's counts agree
+static bool countsAgree(QueueBase &q)
+{
+	int active = 0;
+	int inactive = 0;
+	for ( int i=0; i<q.size(); i++ )
+	{
+		if ( q.getRaw((q.front()+i)%q.maxSize()).reset ) inactive++;
+		else active++;
+	}
+	return q.numActive()==active && q.numInActive()==inactive;
+}
+
+// Randomized check, codes drawn from a range about 1.5 times capacity
+template <int N>
+void check(void)
+{
+	static Queue<N> q(0, "Q", false, 0);
+	srand(N);
+	const unsigned long codes = N<100 ? 40 : N*3/2;
+	int bad = 0;
+	int badCounts = 0;
+	for ( int k=0; k<200000; k++ )
+	{
+		int op = rand()%100;
+		unsigned long cod = 1+rand()%codes;
+		if ( op<90 )
+		{
+			bool fresh = !scanFind(q, cod);
+			int rear = q.rear();
+			q.newCode(k, cod);
+			if ( (q.rear()!=rear)!=fresh ) bad++;   // Logged only if fresh
+		}
+		else if ( op<92 ) q.resetAll();
+		else if ( op<95 ) q.Dequeue();
+		else if ( op<96 ) q.loadRaw(rand()%N, FaultCode(k, cod, rand()%2));
+		if ( k%7==0 && !countsAgree(q) ) badCounts++;
+	}
+	printf("N=%-4d  200000 operations, %d duplicate answers and %d counts differ from a scan\n", N, bad, badCounts);
+	failed += bad+badCounts;
+}
+
+// True if range r yields, in order, the entries an index walk picks for view
+static bool rangeMatches(QueueBase &q, QueueRange r, const QueueView view, const bool reverse)
+{
+	int n = q.size();
+	int i = 0;
+	for ( FaultCode f : r )
+	{
+		int k;
+		do
+		{
+			if ( i>=n ) return false;
+			k = (q.front() + (reverse ? n-1-i : i))%q.maxSize();
+			i++;
+		} while ( view!=allCodes && (view==activeCodes)==q.getRaw(k).reset );
+		FaultCode g = q.getRaw(k);
+		if ( f.time!=g.time || f.code!=g.code || f.reset!=g.reset ) return false;
+	}
+	for ( ; i<n; i++ )
+	{
+		bool reset = q.getRaw((q.front() + (reverse ? n-1-i : i))%q.maxSize()).reset;
+		if ( view==allCodes || (view==activeCodes)!=reset ) return false;
+	}
+	return true;
+}
+
+// All three views, both directions, through random changes
+template <int N>
+void views(void)
+{
+	static Queue<N> q(0, "Q", false, 0);
+	srand(N+1);
+	int bad = 0;
+	for ( int k=0; k<20000; k++ )
+	{
+		int op = rand()%100;
+		if ( op<70 ) q.newCode(k, 1+rand()%(N+5));
+		else if ( op<75 ) q.resetAll();
+		else if ( op<95 ) q.Dequeue();
+		for ( QueueView v : {allCodes, activeCodes, resetCodes} )
+			if ( !rangeMatches(q, q.codes(v), v, false) || !rangeMatches(q, q.codesReverse(v), v, true) ) bad++;
+	}
+	printf("N=%-4d  views differ from an index walk %d times\n", N, bad);
+	failed += bad;
+}
+
+// Mean ns per newCode on a full queue against the ring scan it replaced
+template <int N>
+void bench(void)
+{
+	static Queue<N> q(0, "Q", false, 0);
+	for ( int i=1; i<=N; i++ ) q.newCode(i, i);
+	const int reps = 2000000/N+1000;
+	volatile bool sink = false;
+	unsigned long t0 = micros();
+	for ( int k=0; k<reps; k++ ) q.newCode(k, 1+k%N);
+	unsigned long indexed = micros()-t0;
+	t0 = micros();
+	for ( int k=0; k<reps; k++ ) sink = scanFind(q, 1+k%N);
+	unsigned long scanned = micros()-t0;
+	(void)sink;
+	printf("N=%-4d  newCode %7.1f ns, ring scan %9.1f ns\n", N, 1000.0*indexed/reps, 1000.0*scanned/reps);
+}
+
+int main()
+{
+	check<30>();
+	check<256>();
+	check<4096>();
+	views<2>();
+	views<30>();
+	views<60>();
+	bench<30>();
+	bench<256>();
+	bench<4096>();
+	return failed!=0;
+}
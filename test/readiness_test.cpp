@@ -0,0 +1,67 @@
+#include "application.h"
+#include "myReadiness.h"
+
+// PID 0101 replies as the adapter sends them, through tokenize() into
+// Readiness:  the first decode reports every supported monitor and the MIL,
+// a repeat reports nothing, and a completing monitor or a MIL clear each
+// raise exactly one event.  A reply cut short changes nothing.
+
+static int failed = 0;
+static int events = 0;
+static int lastMon = -1;
+static bool lastComplete = false;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// Readiness event, recorded
+static void changed(const uint8_t mon, const bool supported, const bool complete)
+{
+	(void)supported;
+	events++;
+	lastMon = mon;
+	lastComplete = complete;
+}
+
+// Decode one 0101 reply and return the events it raised
+static int feed(Readiness &r, const char *rx)
+{
+	ObdLine line;
+	tokenize(rx, &line);
+	events = 0;
+	r.update(line.span().from(2));
+	return events;
+}
+
+int main()
+{
+	Readiness r(changed);
+	FixedText<16> str;
+	r.format(&str);
+	expect(!r.valid() && !strcmp(str, "----------"), "nothing decoded yet");
+
+	// MIL on, 3 DTCs.  8 monitors supported, catalyst and both O2 incomplete
+	expect(feed(r, "41018307E561")==9, "first decode reports 8 monitors and the MIL");
+	expect(r.mil() && r.dtcs()==3 && r.supported()==8 && r.completed()==5 && !r.ready(), "decoded counts");
+	expect(r.isSupported(monEGR) && !r.isSupported(monAC) && !r.isComplete(monCatalyst), "monitor bits");
+	str.clear();
+	r.format(&str);
+	expect(!strcmp(str, "* 5/8 inc"), "display line");
+
+	expect(feed(r, "41018307E561")==0, "a repeat line raises no events");
+	expect(feed(r, "41018307E560")==1 && lastMon==monCatalyst && lastComplete, "catalyst completes, one event");
+	expect(feed(r, "41010007E560")==1 && lastMon==MON_MIL && lastComplete && !r.mil(), "MIL clear, one event");
+	expect(feed(r, "41010007E500")==2 && r.ready(), "both O2 monitors complete, ready");
+	str.clear();
+	r.format(&str);
+	expect(!strcmp(str, "  8/8 RDY"), "ready display line");
+	expect(feed(r, "41010007")==0 && r.ready() && r.supported()==8, "a short reply changes nothing");
+
+	printf("readiness %s\n", failed ? "WRONG" : "decodes 0101 and raises one event per change");
+	return failed!=0;
+}
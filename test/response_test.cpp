@@ -0,0 +1,71 @@
+#include "application.h"
+#include "myQueue.h"
+#include "mySubs.h"
+
+// Adapter lines as getResponse leaves them, spaces and prompt stripped:  each
+// must tokenize to its kind with the data bytes decoded, and parseCodes must
+// read the jumper's mode 03 and 07 strings and reject codes with hex letters.
+
+static int failed = 0;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+int main()
+{
+	const struct
+	{
+		const char 	*rx;
+		LineKind 		kind;
+		uint8_t 		len;
+	} lines[] = {
+		{"410C1AF8", 						lineData, 			4},
+		{"4101830761a1", 				lineData, 			6},
+		{"", 										linePrompt, 		0},
+		{"SEARCHING...", 				lineSearching, 	0},
+		{"NODATA", 							lineNoData, 		0},
+		{"BUSINIT:...OK", 			lineBusInit, 		0},
+		{"BUSINIT:...ERROR", 		lineError, 			0},
+		{"STOPPED", 						lineStopped, 		0},
+		{"?", 									lineError, 			0},
+		{"410C1AF", 						lineError, 			0},   // Odd tail
+		{"CANERROR", 						lineError, 			0},
+	};
+	for ( unsigned i=0; i<sizeof(lines)/sizeof(lines[0]); i++ )
+	{
+		ObdLine line;
+		LineKind kind = tokenize(lines[i].rx, &line);
+		if ( kind!=lines[i].kind || line.kind!=kind || line.len!=lines[i].len )
+		{
+			printf("\"%s\":  %s, %d bytes\n", lines[i].rx, lineName(kind), line.len);
+			failed++;
+		}
+	}
+	ObdLine rpm;
+	tokenize("410C1AF8", &rpm);
+	expect(rpm.span()[0]==0x41 && rpm.span().word(2)==0x1AF8 && rpm.span()[9]==0, "data bytes and reads past the end");
+	expect(rpm.span().from(2).len==2 && rpm.span().from(9).len==0, "span from");
+	expect(rpm.status()==false, "data is no status line");
+
+	unsigned long codes[100];
+	uint8_t n = 0;
+	ObdLine line;
+	tokenize("43012002", &line);
+	expect(parseCodes(line.span(), codes, &n)==1 && n==1 && codes[0]==2002, "jumper mode 03, one code");
+	tokenize("470220122013", &line);
+	expect(parseCodes(line.span(), codes, &n)==2 && codes[0]==2012 && codes[1]==2013, "jumper mode 07, two codes");
+	tokenize("43020133A133", &line);
+	expect(parseCodes(line.span(), codes, &n)==1 && codes[0]==133, "a code with a hex letter is rejected");
+	tokenize("4303013302", &line);
+	expect(parseCodes(line.span(), codes, &n)==0, "count beyond the bytes");
+	tokenize("4300", &line);
+	expect(parseCodes(line.span(), codes, &n)==0 && n==0, "no codes");
+
+	printf("adapter lines %s\n", failed ? "WRONG" : "tokenize to their kinds and codes parse from bytes");
+	return failed!=0;
+}
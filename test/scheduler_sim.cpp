@@ -0,0 +1,106 @@
+#include "application.h"
+#include "myScheduler.h"
+#include "myObdIo.h"
+#include "fake_elm.h"
+#include <thread>
+
+// Deadline-ordered dispatch on the simulated clock.  Two tasks released
+// together must run earliest deadline first, and a pass longer than its
+// period must count as an overrun, a miss and a skip.  The whole sketch then
+// boots against the scripted adapter and runs its first minute, which must
+// not miss:  setup() takes seconds and the first releases used to count from
+// boot.  Last, a synthetic load with the sketch's periods and pessimistic run
+// times runs for an hour on a scheduler of its own, and the table is printed.
+
+void setup(void);
+void loop(void);
+extern ObdIo 			obd;
+extern Scheduler 	tasks;
+
+static int failed = 0;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// Charge ms of work to the simulated clock
+static void work(const unsigned long ms)
+{
+	stubMillis += ms;
+}
+
+static void slow(const unsigned long) 	{ work(250); }
+static void quick(const unsigned long) 	{ work(10); }
+static void trend(const unsigned long) 	{ work(60); }
+static void sample(const unsigned long) { work(1500+rand()%1500); }
+static void read(const unsigned long) 	{ work(2500+rand()%4000); }
+static void show(const unsigned long) 	{ work(20); }
+static void reset(const unsigned long) 	{ work(1000+rand()%4000); }
+
+// Print a scheduler's table in a fixed order
+static void table(Scheduler &S, const int n)
+{
+	for ( int i=0; i<n; i++ )
+	{
+		const Task *T = S.task(i);
+		printf("  %-8s runs %5lu  miss %4lu  skip %4lu  maxLate %5lu  maxRun %5lu\n", T->name, T->runs, T->misses,\
+			T->skips, T->maxLate, T->maxRun);
+	}
+}
+
+int main()
+{
+	{
+		Scheduler S(0);
+		unsigned long t0 = millis();
+		int s = S.add("slow",  slow,  100UL, 100UL, 50UL, 0UL);
+		int q = S.add("quick", quick, 100UL, 30UL,  20UL, 0UL);
+		S.start(t0);
+		expect(S.dispatch(millis())==q, "earliest deadline runs first");
+		expect(S.dispatch(millis())==s, "then the other");
+		const Task *T = S.task(s);
+		expect(T->runs==1 && T->maxLate==10UL && T->overruns==1 && T->misses==1 && T->skips==1,\
+			"a pass longer than its period overruns, misses and skips");
+		expect(S.dispatch(millis())==q && S.task(q)->misses==1, "the delayed task misses");
+		expect(S.task(s)->release==t0+200UL, "the next release stays on the grid");
+	}
+
+	fakeElmAttach();
+	setup();
+	unsigned long booted = millis();
+	while ( stubMillis<booted+60000UL )
+	{
+		loop();
+		stubMillis += 10UL;
+		std::this_thread::yield();
+	}
+	obd.stop();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	printf("sketch, first minute after a %lu ms setup:\n", booted);
+	int n = 0;
+	for ( ; tasks.task(n); n++ ) expect(tasks.task(n)->misses==0, "no misses in the first minute");
+	table(tasks, n);
+
+	srand(41);
+	Scheduler S(0);
+	S.add("trend",   trend,  250UL,    250UL,   150UL,  0UL);
+	S.add("sample",  sample, 5000UL,   5000UL,  3000UL, 5000UL);
+	S.add("read",    read,   30000UL,  10000UL, 6000UL, 0UL);
+	S.add("display", show,   30000UL,  5000UL,  100UL,  30000UL);
+	S.add("reset",   reset,  90000UL,  30000UL, 3000UL, 90000UL);
+	unsigned long t0 = millis();
+	S.start(t0);
+	while ( stubMillis<t0+3600000UL )
+	{
+		if ( S.dispatch(millis())<0 ) stubMillis += 1UL;
+	}
+	printf("synthetic load, one hour:\n");
+	table(S, 5);
+	for ( int i=0; i<5; i++ ) expect(S.task(i)->runs>0, "every task runs");
+	printf("scheduler %s\n", failed ? "WRONG" : "dispatches earliest deadline first");
+	return failed!=0;
+}
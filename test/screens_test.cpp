@@ -0,0 +1,55 @@
+#include "application.h"
+#include "myQueue.h"
+#include "myScreens.h"
+#include "mySubs.h"
+
+// Compositor rotation on the simulated clock:  each screen stays up for its
+// dwell, disabled screens are skipped, and a screen is redrawn only when it
+// is on show and stale.  display() with a hold must return at once.
+
+static int failed = 0;
+static int drawn[3];
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+static void renderA(MicroOLED *oled) { (void)oled; drawn[0]++; }
+static void renderB(MicroOLED *oled) { (void)oled; drawn[1]++; }
+static void renderC(MicroOLED *oled) { (void)oled; drawn[2]++; }
+
+int main()
+{
+	MicroOLED oled;
+	Compositor screens(&oled, 0);
+	int a = screens.add("A", renderA, 1000UL);
+	int b = screens.add("B", renderB, 3000UL);
+	int c = screens.add("C", renderC, 500UL);
+
+	expect(screens.tick(0UL) && screens.current()==a && drawn[0]==1, "first tick draws the first screen");
+	expect(!screens.tick(999UL) && drawn[0]==1, "a clean screen is not redrawn within its dwell");
+	screens.invalidate(b);
+	expect(!screens.tick(999UL) && drawn[1]==0, "a stale screen off show is not drawn");
+	screens.invalidate(a);
+	expect(screens.tick(999UL) && drawn[0]==2, "a stale screen on show is redrawn");
+	expect(screens.tick(1000UL) && screens.current()==b, "dwell over, next screen");
+	expect(!screens.tick(3999UL) && screens.current()==b, "second screen keeps its own dwell");
+
+	screens.enable(c, false);
+	expect(screens.tick(4000UL) && screens.current()==a && drawn[2]==0, "disabled screen skipped");
+	screens.enable(c, true);
+	screens.show(c, 4100UL);
+	expect(screens.current()==c && drawn[2]==1, "show jumps to a screen at once");
+	expect(screens.tick(4600UL) && screens.current()==a, "dwell restarts from show");
+
+	unsigned long t0 = millis();
+	display(&oled, 0, 0, "hold", 5000);
+	expect(millis()==t0, "display returns without its hold");
+
+	printf("compositor %s\n", failed ? "WRONG" : "rotates on dwell and redraws only stale screens on show");
+	return failed!=0;
+}
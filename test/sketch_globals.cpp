@@ -0,0 +1,7 @@
+#include "application.h"
+
+// The sketch's globals that mySubs uses, for harnesses that run the adapter
+// code without the sketch
+int 											verbose 	= 0;
+uint8_t 									rxIndex 	= 0;
+std::atomic<unsigned long> busMicros(0UL);
@@ -0,0 +1,146 @@
+#include "application.h"
+#include <string>
+#include "myTsLog.h"
+
+// Time series log against the rows that went in.  An hour of 1 Hz rows whose
+// values move every 5 s must dump back exactly, at the sketch's sizes, and a
+// small ring that recycles pages must dump the newest rows it still holds.
+// Then the pages kept in NVM:  a drive is logged and stored as taskReset does
+// and a fresh log loads it.  Its rows must be the newest sealed pages of the
+// first, in order, and rows added after the reload must follow them.  A store
+// with nothing sealed writes nothing, a corrupt slot is skipped, and an hour of
+// driving reports the EEPROM bytes it costs.
+
+static int failed = 0;
+
+// Count and report a failed expectation
+static void expect(const bool ok, const char *what)
+{
+	if ( ok ) return;
+	printf("failed:  %s\n", what);
+	failed++;
+}
+
+// CSV rows of a log, header dropped
+static std::string rowsOf(TsLogBase &log)
+{
+	Serial.out.clear();
+	Serial.capture = true;
+	log.dump("speed,rpm,coolant");
+	Serial.capture = false;
+	return Serial.out.substr(Serial.out.find('\n')+1);
+}
+
+// Values t seconds into a drive:  speed kph, rpm, coolant C, moving every 5 s
+static void values(const uint32_t t, long v[3])
+{
+	uint32_t s = t/5;
+	v[0] = (s*7)%90;
+	v[1] = 800 + v[0]*30 + (s%3)*10;
+	v[2] = 20 + (t<600 ? t/10 : 60) + (s%41==0);
+}
+
+// Log n rows from t0 and return the CSV they should dump as
+static std::string fill(TsLogBase &log, const uint32_t t0, const uint32_t n)
+{
+	std::string want;
+	for ( uint32_t t=0; t<n; t++ )
+	{
+		long v[3];
+		values(t, v);
+		log.add(t0+t, v);
+		char row[64];
+		snprintf(row, sizeof(row), "%lu,%ld,%ld,%ld\n", (unsigned long)(t0+t), v[0], v[1], v[2]);
+		want += row;
+	}
+	return want;
+}
+
+// Row t seconds into a drive that started at t0
+static void drive(TsLogBase &log, const uint32_t t0, const uint32_t t)
+{
+	long v[3];
+	values(t, v);
+	log.add(t0+t, v);
+}
+
+int main()
+{
+	const int start = 300;
+	const uint32_t t0 = 1500000000UL;
+	static TsLog<48, 256, 3> hour(false, 0);
+	std::string want = fill(hour, t0, 3600);
+	expect(rowsOf(hour)==want, "an hour dumps back exactly");
+	expect(hour.rows()==3600, "every row held");
+	unsigned long perSample = hour.bytes()*100/(3600*3);
+
+	TsLog<4, 64, 3> small(false, 0);
+	want = fill(small, t0, 1000);
+	std::string held = rowsOf(small);
+	unsigned long lines = 0UL;
+	for ( size_t i=0; i<held.size(); i++ ) lines += held[i]=='\n';
+	expect(held.size()>0 && want.size()>held.size() && want.compare(want.size()-held.size(), held.size(), held)==0,\
+		"a recycled ring holds the newest rows");
+	expect(lines==small.rows(), "rows() counts what dump prints");
+	small.reset();
+	expect(small.rows()==0 && rowsOf(small).empty(), "reset forgets every row");
+
+	std::string before;
+	{
+		TsLog<8, 64, 3, 2> log(true, 0);
+		log.loadNVM(start);
+		for ( uint32_t t=0; t<1000; t++ )
+		{
+			drive(log, t0, t);
+			if ( t%90==89 ) log.storeNVM(start);
+		}
+		log.storeNVM(start);
+		unsigned long writes = EEPROM.writes;
+		log.storeNVM(start);
+		expect(EEPROM.writes==writes, "a store with no page sealed writes nothing");
+		before = rowsOf(log);
+	}
+
+	std::string restored;
+	{
+		TsLog<8, 64, 3, 2> log(true, 0);
+		log.loadNVM(start);
+		restored = rowsOf(log);
+		expect(log.rows()>0 && log.bytes()>2*sizeof(TsPage), "pages loaded");
+		size_t at = before.find(restored);
+		expect(at!=std::string::npos && at>0 && at+restored.size()<before.size(),\
+			"loaded rows are the newest sealed pages, open page excluded");
+		for ( uint32_t t=2000; t<2010; t++ ) drive(log, t0, t);
+		std::string after = rowsOf(log);
+		TsLog<8, 64, 3> fresh(false, 0);
+		for ( uint32_t t=2000; t<2010; t++ ) drive(fresh, t0, t);
+		expect(after==restored+rowsOf(fresh), "new rows follow the loaded pages");
+	}
+
+	{
+		EEPROM.write(start+sizeof(NvmHeader)+20, EEPROM.read(start+sizeof(NvmHeader)+20)^0x55);
+		TsLog<8, 64, 3, 2> log(true, 0);
+		log.loadNVM(start);
+		std::string one = rowsOf(log);
+		expect(log.rows()>0 && one.size()<restored.size() && restored.find(one)!=std::string::npos,\
+			"a corrupt slot is skipped, the other loads");
+	}
+
+	// An hour at the sketch's sizes, stored every 90 s
+	unsigned long hourBytes;
+	{
+		TsLog<48, 256, 3, 2> log(true, 0);
+		log.loadNVM(start);
+		unsigned long writes = EEPROM.writes;
+		for ( uint32_t t=0; t<3600; t++ )
+		{
+			drive(log, t0, t);
+			if ( t%90==89 ) log.storeNVM(start);
+		}
+		hourBytes = EEPROM.writes-writes;
+	}
+
+	printf("time series %s;  %lu.%02lu bytes per sample with headers, %lu EEPROM bytes an hour\n",\
+		failed ? "WRONG" : "dumps back exactly and reloads in order", perSample/100, perSample%100, hourBytes);
+	return failed!=0;
+}
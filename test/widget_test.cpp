@@ -0,0 +1,53 @@
+#include "application.h"
+#include "myWidgets.h"
+
+// Incremental widget updates against a full redraw.  After every sample the
+// page buffer must equal clear()+draw(), and the gauge extremes must be those
+// of its last GAUGE_SAMPLES samples.  Prints the mean update cost.
+
+int main()
+{
+	MicroOLED oled;
+	oled.begin();
+	BarGauge 	gauge(&oled, 2, 2, 60, 8, 0, 7000);
+	Sparkline trace(&oled, 0, 16, 64, 30, 0, 7000);
+	oled.clear(PAGE);
+	gauge.draw();
+	trace.draw();
+	srand(3);
+	const int n = 2000;
+	long history[n];
+	uint8_t inc[LCDWIDTH*LCDHEIGHT/8];
+	int bad = 0;
+	unsigned long us = 0;
+	int updates = 0;
+	for ( int k=0; k<n; k++ )
+	{
+		long v = rand()%8000-500;
+		history[k] = v;
+		bool visible = k%7!=3;
+		unsigned long t0 = micros();
+		gauge.update(v, visible);
+		trace.update(v, visible);
+		if ( visible ) { us += micros()-t0; updates++; }
+		memcpy(inc, oled.getScreenBuffer(), sizeof(inc));
+		oled.clear(PAGE);
+		gauge.draw();
+		trace.draw();
+		if ( visible && memcmp(inc, oled.getScreenBuffer(), sizeof(inc)) ) bad++;
+
+		long lo = v, hi = v;
+		for ( int i=k; i>=0 && i>k-GAUGE_SAMPLES; i-- )
+		{
+			if ( history[i]<lo ) lo = history[i];
+			if ( history[i]>hi ) hi = history[i];
+		}
+		if ( gauge.min()!=lo || gauge.max()!=hi )
+		{
+			printf("sample %d:  extremes %ld..%ld want %ld..%ld\n", k, gauge.min(), gauge.max(), lo, hi);
+			return 1;
+		}
+	}
+	printf("%d samples, %d frames differ from a full redraw, %.2f us per update pair\n", n, bad, (double)us/updates);
+	return bad!=0;
+}